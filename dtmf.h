@@ -0,0 +1,241 @@
+///////////////////////////////////////////////////////////////////////////////
+//          University of Hawaii, College of Engineering
+//          ee469_lab01_dtmf_wav_gen - EE 469 - Fall 2022
+//
+/// The dtmf library:  DTMF tone synthesis and Goertzel detection
+///
+/// Everything here works on handles that live in memory the caller owns
+/// and on buffers the caller passes in.  The library never allocates and
+/// has no global state, so separate handles can be used from separate
+/// threads.  A single handle is not thread-safe.
+///
+/// Audio is linear, unsigned 8-bit mono PCM where silence is 127.
+///
+/// ABI policy:  The handles (dtmf_schedule, dtmf_synth and dtmf_detector)
+/// are opaque.  Ask dtmf_X_size() how much memory one needs, then
+/// dtmf_X_init() it in place.  The memory has to be aligned like malloc()'s.
+/// Their layout can change without breaking callers, so the library's
+/// tuning is private to it.  The function signatures, the enums and
+/// dtmf_event_info are the ABI; changing any of them bumps SOVERSION.
+///
+/// @file dtmf.h
+/// @version 1.0
+///
+/// @author Mark Nelson <marknels@hawaii.edu>
+/// @date   04_Oct_2022
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stddef.h>  // For size_t
+#include <stdint.h>  // For fixed-length ints
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DTMF_KEYPAD_FREQUENCY_COUNT   8    /* 4 rows, then 4 columns          */
+#define DTMF_MAX_FREQUENCIES         64    /* Per detector                    */
+#define DTMF_SCHEDULE_LINE_LENGTH  1024    /* Longest line in a schedule      */
+
+#define DTMF_DEFAULT_TONE_DURATION_IN_MS      200  /* dur= for every event     */
+#define DTMF_DEFAULT_INTER_TONE_SILENCE_IN_MS 100  /* gap= for dtmf events     */
+#define DTMF_DEFAULT_AMPLITUDE                0.8  /* amp= for every event     */
+#define DTMF_MAX_TWIST_IN_DB                   20  /* twist= is within +/- this */
+
+
+/// What every function that can fail returns
+typedef enum dtmf_status {
+    DTMF_OK = 0
+   ,DTMF_ERROR_ARGUMENT       /// A NULL handle, zero rate, etc.
+   ,DTMF_ERROR_FULL           /// The caller's event array is too small
+   ,DTMF_ERROR_SYNTAX         /// A schedule line couldn't be parsed
+   ,DTMF_ERROR_UNKNOWN_EVENT  /// A schedule line starts with an unknown kind
+   ,DTMF_ERROR_RANGE          /// A number is out of range
+   ,DTMF_ERROR_TOO_LONG       /// The schedule won't fit in a .wav file
+} dtmf_status;
+
+
+/// @returns A short, static description of status
+const char* dtmf_strerror( dtmf_status status );
+
+
+/// The DTMF frequencies in Hz:  Rows first, then columns
+extern const float dtmf_keypad_hz[ DTMF_KEYPAD_FREQUENCY_COUNT ];
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Synthesis
+
+
+/// The kinds of events in a schedule
+typedef enum dtmf_event_kind {
+    DTMF_EVENT_DTMF      /// A DTMF digit (two mixed tones)
+   ,DTMF_EVENT_TONE      /// A single sine wave
+   ,DTMF_EVENT_SAW       /// A sawtooth (0, 1, 2, ... 255, 0, 1 ...)
+   ,DTMF_EVENT_SILENCE   /// Nothing (but noise, if any)
+   ,DTMF_EVENT_NOISE     /// White noise
+} dtmf_event_kind;
+
+
+/// What the caller can see of a compiled event
+typedef struct dtmf_event_info {
+   dtmf_event_kind kind;
+   char     digit;         /// The DTMF digit
+   uint32_t frequency[2];  /// In Hz.  Row & column for DTMF.
+   uint32_t start;         /// Offset of the event's first sample
+   uint32_t tone_samples;  /// Samples of signal...
+   uint32_t gap_samples;   /// ...followed by samples of silence
+} dtmf_event_info;
+
+
+/// A schedule compiled into a flat array of events (opaque)
+typedef struct dtmf_schedule dtmf_schedule;
+
+
+/// @returns The bytes of memory a schedule with room for capacity events needs
+size_t dtmf_schedule_size( size_t capacity );
+
+
+/// Start an empty schedule in memory[ size ]
+dtmf_status dtmf_schedule_init( void* memory, size_t size, uint32_t sample_rate, dtmf_schedule** schedule );
+
+
+/// Pick up a schedule whose memory has been copied (or realloc()'d) into a
+/// bigger memory[ size ], and use the extra room for events
+///
+/// No synth may be rendering the schedule while it moves.
+dtmf_status dtmf_schedule_resize( void* memory, size_t size, dtmf_schedule** schedule );
+
+
+/// @returns The number of events in schedule
+size_t dtmf_schedule_count( const dtmf_schedule* schedule );
+
+
+/// @returns The number of samples the schedule renders, known before
+///          rendering starts
+uint32_t dtmf_schedule_total_samples( const dtmf_schedule* schedule );
+
+
+/// Describe event number index of schedule
+dtmf_status dtmf_schedule_event( const dtmf_schedule* schedule, size_t index, dtmf_event_info* info );
+
+
+/// Compile one line of a schedule and append its events
+///
+/// Each line is:  <kind> [<argument>] [key=value ...]
+///
+///    dtmf    <digits>   One event per digit.  gap defaults to
+///                       DTMF_DEFAULT_INTER_TONE_SILENCE_IN_MS.
+///    tone    <Hz>
+///    saw
+///    silence
+///    noise   <level>    level is from 0 to 1
+///
+/// Options are dur=<ms>, gap=<ms>, amp=<0..1>, twist=<dB> and noise=<0..1>.
+/// twist is the level of the column tone relative to the row tone, within
+/// +/- DTMF_MAX_TWIST_IN_DB.
+/// Numbers are decimal and always use '.', whatever the process's locale.
+/// Blank lines and lines starting with # are ignored.
+///
+/// Characters in <digits> that aren't on the keypad are skipped, and
+/// counted in *skipped (which may be NULL).
+///
+/// A line is added completely or not at all.  On DTMF_ERROR_FULL, move
+/// the schedule to more memory (see dtmf_schedule_resize()) and compile
+/// the same line again.
+dtmf_status dtmf_schedule_compile_line( dtmf_schedule* schedule, const char* line, size_t* skipped );
+
+
+/// A renderer working its way through a schedule (opaque)
+typedef struct dtmf_synth dtmf_synth;
+
+
+/// @returns The bytes of memory a synth needs
+size_t dtmf_synth_size( void );
+
+
+/// Start rendering schedule from the beginning
+///
+/// The schedule must outlive the synth.
+dtmf_status dtmf_synth_init( void* memory, size_t size, const dtmf_schedule* schedule, dtmf_synth** synth );
+
+
+/// Render up to capacity samples of PCM into pcm
+///
+/// @param rendered Gets the number of samples rendered.  0 (with DTMF_OK)
+///                 means the schedule is done.
+dtmf_status dtmf_synth_render( dtmf_synth* synth, uint8_t* pcm, size_t capacity, size_t* rendered );
+
+
+/// @returns The number of events that have been completely rendered
+size_t dtmf_synth_position( const dtmf_synth* synth );
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Detection
+
+
+/// A bank of Goertzel filters behind a polyphase decimating front end (opaque)
+typedef struct dtmf_detector dtmf_detector;
+
+
+/// @returns The bytes of memory a detector needs
+size_t dtmf_detector_size( void );
+
+
+/// Set up a detector in memory[ size ]
+///
+/// Input above detect_rate is low-pass filtered and decimated to about
+/// detect_rate before it reaches the Goertzel bank, so the cost of
+/// detection doesn't depend on the capture rate.  The factor is reduced if
+/// a frequency would fall outside the flat passband, and decimation is
+/// skipped when frame_length is shorter than the filter.
+///
+/// @param detect_rate  0 disables decimation
+/// @param frame_length The number of samples that will be in each frame
+dtmf_status dtmf_detector_init( void* memory
+                               ,size_t size
+                               ,uint32_t sample_rate
+                               ,uint32_t detect_rate
+                               ,const float* frequencies
+                               ,size_t frequency_count
+                               ,size_t frame_length
+                               ,dtmf_detector** detector );
+
+
+/// @returns The decimation factor that was picked (1 = no decimation)
+int dtmf_detector_factor( const dtmf_detector* detector );
+
+
+/// @returns The rate the Goertzel bank runs at, after decimation
+uint32_t dtmf_detector_detect_rate( const dtmf_detector* detector );
+
+
+/// Forget the filter history (to start on a new, unrelated stream)
+void dtmf_detector_reset( dtmf_detector* detector );
+
+
+/// Compute the magnitude of every frequency over one frame
+///
+/// Consecutive frames are treated as one continuous stream.
+///
+/// @param magnitudes Gets frequency_count values, in the order given to
+///                   dtmf_detector_init()
+dtmf_status dtmf_detector_process( dtmf_detector* detector
+                                  ,const uint8_t* pcm
+                                  ,size_t count
+                                  ,float* magnitudes );
+
+
+/// Find the key from the magnitudes of dtmf_keypad_hz (rows, then columns)
+/// by picking the strongest row and column.
+///
+/// @returns The key ('0'-'9', '*', '#', 'A'-'D') or '-' if either the row
+///          or the column isn't over threshold
+char dtmf_decode_key( const float* magnitudes, float threshold );
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,71 @@
+///////////////////////////////////////////////////////////////////////////////
+//          University of Hawaii, College of Engineering
+//          ee469_lab01_dtmf_wav_gen - EE 469 - Fall 2022
+//
+/// The detector's decimating lowpass, shared by the detector and the table
+/// generator
+///
+/// gen_dtmf_tables designs the filter for every factor in
+/// DTMF_DECIMATOR_TABLE_FACTORS at build time.  The detector only designs
+/// it at runtime for other factors.
+///
+/// @file dtmf_decimator.h
+/// @version 1.0
+///
+/// @author Mark Nelson <marknels@hawaii.edu>
+/// @date   23_Oct_2022
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <math.h>  // For sin() and cos()
+
+#define DTMF_DECIMATOR_TAPS_PER_PHASE 16  /* FIR taps per polyphase branch */
+
+#define DTMF_DECIMATOR_TABLE_FACTOR_COUNT 3  /* Factors with precomputed filters */
+#define DTMF_DECIMATOR_TABLE_MAX_TAPS     ( 6 * DTMF_DECIMATOR_TAPS_PER_PHASE )
+
+
+/// The factors the standard rates decimate by to reach 8 kHz:
+/// 16000 / 2, 44100 / 5 (8820 Hz) and 48000 / 6
+static const int DTMF_DECIMATOR_TABLE_FACTORS[ DTMF_DECIMATOR_TABLE_FACTOR_COUNT ] = {
+   2, 5, 6
+};
+
+
+/// @returns The index of factor in DTMF_DECIMATOR_TABLE_FACTORS or -1
+static inline int dtmf_decimator_factor_index( int factor ) {
+   for( int i = 0 ; i < DTMF_DECIMATOR_TABLE_FACTOR_COUNT ; i++ ) {
+      if( DTMF_DECIMATOR_TABLE_FACTORS[i] == factor ) {
+         return i;
+      }
+   }
+   return -1;
+}
+
+
+/// Design a Blackman-windowed sinc lowpass with factor *
+/// DTMF_DECIMATOR_TAPS_PER_PHASE taps into h[]
+///
+/// The cutoff is 0.4 of the decimated rate, so aliases of everything up to
+/// the decimated Nyquist are down by ~70 dB before they fold back into
+/// the band where the detector is listening.
+static inline void dtmf_decimator_design( int factor, float* h ) {
+   int    taps   = factor * DTMF_DECIMATOR_TAPS_PER_PHASE;
+   double cutoff = 0.4 / factor;  /// Relative to the input sample rate
+   double center = ( taps - 1 ) / 2.0;
+   double sum    = 0;
+
+   for( int i = 0 ; i < taps ; i++ ) {
+      double x      = i - center;
+      double sinc   = ( x == 0 ) ? 2.0 * cutoff : sin( 2.0 * M_PI * cutoff * x ) / ( M_PI * x );
+      double window = 0.42 - 0.5  * cos( 2.0 * M_PI * i / ( taps - 1 ) )
+                           + 0.08 * cos( 4.0 * M_PI * i / ( taps - 1 ) );
+      h[i] = (float) ( sinc * window );
+      sum += h[i];
+   }
+
+   for( int i = 0 ; i < taps ; i++ ) {
+      h[i] /= sum;  /// Unity gain at DC
+   }
+}
@@ -0,0 +1,271 @@
+///////////////////////////////////////////////////////////////////////////////
+//          University of Hawaii, College of Engineering
+//          ee469_lab01_dtmf_wav_gen - EE 469 - Fall 2022
+//
+/// The dtmf library:  Decimation and Goertzel detection
+///
+/// @see dtmf.h
+/// @see http://en.wikipedia.org/wiki/Goertzel_algorithm
+///
+/// @file dtmf_detect.c
+/// @version 1.0
+///
+/// @author Mark Nelson <marknels@hawaii.edu>
+/// @date   23_Oct_2022
+///////////////////////////////////////////////////////////////////////////////
+
+#include <string.h>  // For memmove(), memcpy()
+#include <math.h>    // For sin(), cos(), sqrtf()
+
+#include "dtmf.h"
+#include "dtmf_tables.h"  // For DTMF_GOERTZEL_COEFF[], DTMF_DECIMATOR_FIR[], etc.
+
+#define DTMF_DECIMATOR_MAX_FACTOR    16    /* 96 kHz -> 6 kHz is as far as we go */
+#define DTMF_DECIMATOR_MAX_TAPS      ( DTMF_DECIMATOR_MAX_FACTOR * DTMF_DECIMATOR_TAPS_PER_PHASE )
+#define DTMF_DECIMATOR_CHUNK       1024    /* Input samples filtered at a time */
+
+
+struct dtmf_detector {
+   uint32_t sample_rate;      /// Of the input
+   uint32_t detect_rate;      /// After decimation
+   size_t   frequency_count;
+   float    frequency[ DTMF_MAX_FREQUENCIES ];
+   float    cosine[ DTMF_MAX_FREQUENCIES ];
+   float    sine[ DTMF_MAX_FREQUENCIES ];
+   float    coeff[ DTMF_MAX_FREQUENCIES ];   /// 2 * cosine
+
+   int      factor;           /// Keep 1 of every factor samples (1 = bypass)
+   int      taps;             /// factor * DTMF_DECIMATOR_TAPS_PER_PHASE
+   int      carry;            /// Samples held over in pending[]
+   float    h[ DTMF_DECIMATOR_MAX_TAPS ];
+   float    pending[ DTMF_DECIMATOR_MAX_TAPS + DTMF_DECIMATOR_CHUNK ];
+};
+
+
+/// Sized by dtmf_keypad.h, so if dtmf.h's DTMF_KEYPAD_FREQUENCY_COUNT falls
+/// out of step, this conflicts with its declaration and won't compile
+const float dtmf_keypad_hz[ DTMF_FREQUENCY_COUNT ] = DTMF_FREQUENCIES_INITIALIZER;
+
+
+/// Pick a factor that brings sample_rate down to about detect_rate, while
+/// keeping maxfreq well inside the decimated passband.
+///
+/// @returns 1 if decimation wouldn't help (or frames are shorter than the filter)
+static int decimation_factor(uint32_t sample_rate, uint32_t detect_rate, float maxfreq, size_t frame_length) {
+   if(detect_rate == 0) return 1;
+
+   int factor = sample_rate / detect_rate;
+   if(factor > DTMF_DECIMATOR_MAX_FACTOR) factor = DTMF_DECIMATOR_MAX_FACTOR;
+
+   //The passband is flat to about 0.23 of the decimated rate (see dtmf_decimator_design())
+   while(factor > 1 && maxfreq > 0.23f * sample_rate / factor) factor--;
+   if(factor > 1 && frame_length < (size_t)factor * DTMF_DECIMATOR_TAPS_PER_PHASE) return 1;
+
+   return factor < 1 ? 1 : factor;
+}
+
+/// Polyphase filter and decimate count (<= DTMF_DECIMATOR_CHUNK) samples
+///
+/// Each chunk is split into factor phase streams (every factor-th sample),
+/// and each branch of the filter runs over its own stream at the decimated
+/// rate.  The inner loop walks every output of the chunk, which is
+/// contiguous and independent so the compiler can vectorize it.  The
+/// filter state carries across calls in pending[].
+///
+/// @returns The number of samples written to out
+static int decimate(dtmf_detector *d, const uint8_t *in, int count,
+                    float *restrict phases, float *restrict out) {
+   int i, n, p, q;
+   int factor = d->factor;
+   int length = d->carry + count;
+   for(i=0;i<count;i++) d->pending[d->carry + i] = in[i];
+
+   if(length < d->taps) {
+      d->carry = length;
+      return 0;
+   }
+
+   //Output n is h[] dotted with pending[n*factor ...]
+   int produced = (length - d->taps) / factor + 1;
+   int stream = produced + DTMF_DECIMATOR_TAPS_PER_PHASE - 1;
+
+   //phases[p*stream + m] = pending[m*factor + p]
+   for(p=0;p<factor;p++) {
+      float *restrict x = &phases[p * stream];
+      for(n=0;n<stream;n++) x[n] = d->pending[n * factor + p];
+   }
+
+   //Gather each branch's coefficients so the inner loop reads them in order
+   float branch[DTMF_DECIMATOR_TAPS_PER_PHASE];
+
+   for(n=0;n<produced;n++) out[n] = 0;
+   for(p=0;p<factor;p++) {
+      for(q=0;q<DTMF_DECIMATOR_TAPS_PER_PHASE;q++) branch[q] = d->h[q * factor + p];
+      const float *restrict x = &phases[p * stream];
+      for(n=0;n<produced;n++) {
+         float sum = out[n];
+         for(q=0;q<DTMF_DECIMATOR_TAPS_PER_PHASE;q++) sum += branch[q] * x[n + q];
+         out[n] = sum;
+      }
+   }
+
+   //Keep what the next chunk's first output needs
+   int next = produced * factor;
+   d->carry = length - next;
+   memmove(d->pending, &d->pending[next], d->carry * sizeof(float));
+
+   return produced;
+}
+
+size_t dtmf_detector_size( void ) {
+   return sizeof(struct dtmf_detector);
+}
+
+dtmf_status dtmf_detector_init( void* memory
+                               ,size_t size
+                               ,uint32_t sample_rate
+                               ,uint32_t detect_rate
+                               ,const float* frequencies
+                               ,size_t frequency_count
+                               ,size_t frame_length
+                               ,dtmf_detector** handle ) {
+   if(memory == NULL || (uintptr_t)memory % _Alignof(struct dtmf_detector) != 0
+      || size < sizeof(struct dtmf_detector) || handle == NULL
+      || sample_rate == 0 || frequencies == NULL
+      || frequency_count == 0 || frequency_count > DTMF_MAX_FREQUENCIES) {
+      return DTMF_ERROR_ARGUMENT;
+   }
+
+   dtmf_detector *detector = memory;
+
+   size_t k;
+   float maxfreq = 0;
+   for(k=0;k<frequency_count;k++) {
+      if(frequencies[k] <= 0) return DTMF_ERROR_RANGE;
+      if(frequencies[k] > maxfreq) maxfreq = frequencies[k];
+   }
+
+   //Everything after the front end runs at the decimated rate
+   detector->sample_rate = sample_rate;
+   detector->factor = decimation_factor(sample_rate, detect_rate, maxfreq, frame_length);
+   detector->taps = detector->factor * DTMF_DECIMATOR_TAPS_PER_PHASE;
+   detector->detect_rate = sample_rate / detector->factor;
+   if(detector->factor > 1) {
+      //The filters for the standard rates' factors come from the tables
+      //generated at build time.  Any other factor is designed once, here.
+      int factor_index = dtmf_decimator_factor_index(detector->factor);
+      if(factor_index >= 0) {
+         memcpy(detector->h, DTMF_DECIMATOR_FIR[factor_index], detector->taps * sizeof(float));
+      } else {
+         dtmf_decimator_design(detector->factor, detector->h);
+      }
+   }
+   dtmf_detector_reset(detector);
+
+   //DTMF frequencies at the standard rates (and the rates they decimate
+   //to) come from the tables too.  Anything else is computed once, here.
+   int rate_index = dtmf_rate_index(detector->detect_rate);
+   detector->frequency_count = frequency_count;
+   for(k=0;k<frequency_count;k++) {
+      int freq_index = dtmf_frequency_index(frequencies[k]);
+      detector->frequency[k] = frequencies[k];
+      if(rate_index >= 0 && freq_index >= 0) {
+         detector->cosine[k] = DTMF_GOERTZEL_COEFF[rate_index][freq_index].cosine;
+         detector->sine[k]   = DTMF_GOERTZEL_COEFF[rate_index][freq_index].sine;
+         detector->coeff[k]  = DTMF_GOERTZEL_COEFF[rate_index][freq_index].coeff;
+      } else {
+         float omega = (2.0 * M_PI * frequencies[k]) / (float)detector->detect_rate;
+         detector->cosine[k] = cos(omega);
+         detector->sine[k]   = sin(omega);
+         detector->coeff[k]  = 2.0 * detector->cosine[k];
+      }
+   }
+
+   *handle = detector;
+   return DTMF_OK;
+}
+
+int dtmf_detector_factor( const dtmf_detector* detector ) {
+   return detector == NULL ? 1 : detector->factor;
+}
+
+uint32_t dtmf_detector_detect_rate( const dtmf_detector* detector ) {
+   return detector == NULL ? 0 : detector->detect_rate;
+}
+
+void dtmf_detector_reset( dtmf_detector* detector ) {
+   if(detector == NULL || detector->factor <= 1) return;
+
+   //Start with taps-factor samples of silence, so every factor samples in
+   //produces exactly one sample out
+   detector->carry = detector->taps - detector->factor;
+   for(int i=0;i<detector->carry;i++) detector->pending[i] = 0;
+}
+
+dtmf_status dtmf_detector_process( dtmf_detector* detector
+                                  ,const uint8_t* pcm
+                                  ,size_t count
+                                  ,float* magnitudes ) {
+   if(detector == NULL || (pcm == NULL && count > 0) || magnitudes == NULL) {
+      return DTMF_ERROR_ARGUMENT;
+   }
+
+   size_t k, i;
+   size_t total = 0;  //Samples that reached the Goertzel bank
+   float q1[DTMF_MAX_FREQUENCIES] = {0};
+   float q2[DTMF_MAX_FREQUENCIES] = {0};
+
+   float phases[DTMF_DECIMATOR_MAX_TAPS + DTMF_DECIMATOR_CHUNK];
+   float samples[DTMF_DECIMATOR_CHUNK];
+
+   //The Goertzel recurrence carries across chunks, so frames can be any size
+   for(size_t offset=0; offset<count; offset+=DTMF_DECIMATOR_CHUNK) {
+      int n = (count - offset < DTMF_DECIMATOR_CHUNK) ? (int)(count - offset) : DTMF_DECIMATOR_CHUNK;
+
+      if(detector->factor > 1) {
+         n = decimate(detector, pcm + offset, n, phases, samples);
+      } else {
+         for(i=0;i<(size_t)n;i++) samples[i] = pcm[offset + i];
+      }
+
+      for(k=0;k<detector->frequency_count;k++) {
+         float coeff = detector->coeff[k];
+         float a = q1[k], b = q2[k];
+         for(i=0;i<(size_t)n;i++) {
+            float q0 = coeff * a - b + samples[i];
+            b = a;
+            a = q0;
+         }
+         q1[k] = a;
+         q2[k] = b;
+      }
+
+      total += n;
+   }
+
+   // calculate the real and imaginary results
+   // scaling appropriately
+   float scalingFactor = total / 2.0;
+   for(k=0;k<detector->frequency_count;k++) {
+      if(total == 0) {
+         magnitudes[k] = 0;
+         continue;
+      }
+      float real = (q1[k] * detector->cosine[k] - q2[k]) / scalingFactor;
+      float imag = (q1[k] * detector->sine[k]) / scalingFactor;
+      magnitudes[k] = sqrtf(real*real + imag*imag);
+   }
+
+   return DTMF_OK;
+}
+
+char dtmf_decode_key( const float* magnitudes, float threshold ) {
+   int row = 0, col = 0, i;
+   if(magnitudes == NULL) return '-';
+
+   for(i=1;i<DTMF_ROWS;i++) if(magnitudes[i] > magnitudes[row]) row = i;
+   for(i=1;i<DTMF_COLS;i++) if(magnitudes[DTMF_ROWS+i] > magnitudes[DTMF_ROWS+col]) col = i;
+
+   if(magnitudes[row] <= threshold || magnitudes[DTMF_ROWS+col] <= threshold) return '-';
+   return DTMF_KEYPAD[row][col];
+}
@@ -0,0 +1,111 @@
+///////////////////////////////////////////////////////////////////////////////
+//          University of Hawaii, College of Engineering
+//          ee469_lab01_dtmf_wav_gen - EE 469 - Fall 2022
+//
+/// The DTMF keypad, shared by the generator and the detector
+///
+/// The frequencies are indexed rows first, then columns.  The same index
+/// is used by the tables in dtmf_tables.h, which gen_dtmf_tables generates
+/// at build time.
+///
+/// @see https://en.wikipedia.org/wiki/Dual-tone_multi-frequency_signaling
+///
+/// @file dtmf_keypad.h
+/// @version 1.0
+///
+/// @author Mark Nelson <marknels@hawaii.edu>
+/// @date   04_Oct_2022
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>  // For fixed-length ints
+
+#define DTMF_ROW_1        697 /* Hz */
+#define DTMF_ROW_2        770 /* Hz */
+#define DTMF_ROW_3        852 /* Hz */
+#define DTMF_ROW_4        941 /* Hz */
+
+#define DTMF_COL_1       1209 /* Hz */
+#define DTMF_COL_2       1336 /* Hz */
+#define DTMF_COL_3       1477 /* Hz */
+#define DTMF_COL_4       1633 /* Hz */
+
+#define DTMF_ROWS            4
+#define DTMF_COLS            4
+#define DTMF_FREQUENCY_COUNT ( DTMF_ROWS + DTMF_COLS )
+
+#define DTMF_TABLE_RATE_COUNT 5  /* Sample rates with precomputed tables */
+
+
+/// Every DTMF frequency:  Rows first, then columns.  This is the one list;
+/// the library's public dtmf_keypad_hz[] is initialized from it too.
+#define DTMF_FREQUENCIES_INITIALIZER {                  \
+    DTMF_ROW_1, DTMF_ROW_2, DTMF_ROW_3, DTMF_ROW_4      \
+   ,DTMF_COL_1, DTMF_COL_2, DTMF_COL_3, DTMF_COL_4      \
+}
+
+static const uint32_t DTMF_FREQUENCIES[ DTMF_FREQUENCY_COUNT ] = DTMF_FREQUENCIES_INITIALIZER;
+
+
+/// The sample rates that have precomputed tables:  The standard rates, and
+/// 8820 Hz, which is what the detector decimates 44.1 kHz to
+static const uint32_t DTMF_TABLE_SAMPLE_RATES[ DTMF_TABLE_RATE_COUNT ] = {
+   8000, 16000, 44100, 48000, 8820
+};
+
+
+/// The keypad, as it's laid out on a phone
+static const char DTMF_KEYPAD[ DTMF_ROWS ][ DTMF_COLS ] = {
+    { '1', '2', '3', 'A' }
+   ,{ '4', '5', '6', 'B' }
+   ,{ '7', '8', '9', 'C' }
+   ,{ '*', '0', '#', 'D' }
+};
+
+
+/// Encode a keypad position as a non-zero key.  0 means "not a DTMF digit".
+#define DTMF_KEY( row, col )  ( (uint8_t) ( 1 + (row) * DTMF_COLS + (col) ) )
+#define DTMF_KEY_ROW( key )   ( ( (key) - 1 ) / DTMF_COLS )
+#define DTMF_KEY_COL( key )   ( ( (key) - 1 ) % DTMF_COLS )
+
+
+/// Map an ASCII character to its key (case insensitive) with one index
+static const uint8_t DTMF_KEY_INDEX[ 256 ] = {
+    [ '1' ] = DTMF_KEY( 0, 0 ), [ '2' ] = DTMF_KEY( 0, 1 ), [ '3' ] = DTMF_KEY( 0, 2 )
+   ,[ '4' ] = DTMF_KEY( 1, 0 ), [ '5' ] = DTMF_KEY( 1, 1 ), [ '6' ] = DTMF_KEY( 1, 2 )
+   ,[ '7' ] = DTMF_KEY( 2, 0 ), [ '8' ] = DTMF_KEY( 2, 1 ), [ '9' ] = DTMF_KEY( 2, 2 )
+   ,[ '*' ] = DTMF_KEY( 3, 0 ), [ '0' ] = DTMF_KEY( 3, 1 ), [ '#' ] = DTMF_KEY( 3, 2 )
+   ,[ 'A' ] = DTMF_KEY( 0, 3 ), [ 'B' ] = DTMF_KEY( 1, 3 ), [ 'C' ] = DTMF_KEY( 2, 3 ), [ 'D' ] = DTMF_KEY( 3, 3 )
+   ,[ 'a' ] = DTMF_KEY( 0, 3 ), [ 'b' ] = DTMF_KEY( 1, 3 ), [ 'c' ] = DTMF_KEY( 2, 3 ), [ 'd' ] = DTMF_KEY( 3, 3 )
+};
+
+
+/// Precomputed Goertzel terms for one frequency at one sample rate
+struct goertzel_coeff {
+   float cosine;  /// cos( omega )
+   float sine;    /// sin( omega )
+   float coeff;   /// 2 * cos( omega )
+};
+
+
+/// @returns The index of sample_rate in DTMF_TABLE_SAMPLE_RATES or -1
+static inline int dtmf_rate_index( uint32_t sample_rate ) {
+   for( int i = 0 ; i < DTMF_TABLE_RATE_COUNT ; i++ ) {
+      if( DTMF_TABLE_SAMPLE_RATES[i] == sample_rate ) {
+         return i;
+      }
+   }
+   return -1;
+}
+
+
+/// @returns The index of frequency in DTMF_FREQUENCIES or -1
+static inline int dtmf_frequency_index( double frequency ) {
+   for( int i = 0 ; i < DTMF_FREQUENCY_COUNT ; i++ ) {
+      if( DTMF_FREQUENCIES[i] == frequency ) {
+         return i;
+      }
+   }
+   return -1;
+}
@@ -0,0 +1,617 @@
+///////////////////////////////////////////////////////////////////////////////
+//          University of Hawaii, College of Engineering
+//          ee469_lab01_dtmf_wav_gen - EE 469 - Fall 2022
+//
+/// The dtmf library:  Schedules and tone synthesis
+///
+/// @see dtmf.h
+///
+/// @file dtmf_synth.c
+/// @version 1.0
+///
+/// @author Mark Nelson <marknels@hawaii.edu>
+/// @date   04_Oct_2022
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stddef.h>  // For offsetof()
+#include <string.h>  // For strcmp(), strchr()
+#include <math.h>    // For sin(), pow(), isfinite()
+
+#include "dtmf.h"
+#include "dtmf_tables.h"  // For DTMF_KEY_INDEX[], DTMF_PHASE_INCREMENT[], etc.
+
+#define PCM_8_BIT_SILENCE 127     /* Silence is 127                    */
+#define RENDER_BLOCK_SIZE 256     /* Raw samples staged on the stack   */
+
+#define NOISE_SEED        2463534242u  /* Any non-zero value will do   */
+
+
+/// One compiled event.  Everything the renderer needs is precomputed here,
+/// so rendering never parses, looks up or divides.
+struct event {
+   dtmf_event_kind kind;
+   char     digit;         /// The DTMF digit
+   uint32_t frequency[2];  /// In Hz.  Row & column for DTMF.
+   double   increment[2];  /// Phase increments in radians per sample
+   float    level[2];      /// Amplitude of each tone (twist is folded in)
+   float    noise;         /// White noise level from 0 to 1
+   uint32_t start;         /// Offset of the event's first sample
+   uint32_t tone_samples;  /// Samples of signal...
+   uint32_t gap_samples;   /// ...followed by samples of silence
+};
+
+
+/// A schedule, with its events right behind it in the caller's memory
+///
+/// There are no pointers in here, so the caller can move it.
+struct dtmf_schedule {
+   size_t   capacity;
+   size_t   count;
+   uint32_t sample_rate;
+   uint32_t total_samples;  /// Known before rendering starts
+   struct event events[];
+};
+
+
+struct dtmf_synth {
+   const dtmf_schedule* schedule;
+   size_t   event;   /// The event being rendered (== count when done)
+   uint32_t index;   /// The next sample within that event
+   uint32_t noise;   /// State of the noise generator
+};
+
+
+/// The per-event settings that can be given as key=value in a schedule
+struct event_options {
+   uint32_t duration_in_ms;  /// dur=
+   uint32_t gap_in_ms;       /// gap=
+   double   amplitude;       /// amp=
+   double   twist_in_db;     /// twist=
+   double   noise;           /// noise=
+};
+
+
+const char* dtmf_strerror( dtmf_status status ) {
+   switch( status ) {
+      case DTMF_OK:                  return "Success";
+      case DTMF_ERROR_ARGUMENT:      return "Invalid argument";
+      case DTMF_ERROR_FULL:          return "Too many events";
+      case DTMF_ERROR_SYNTAX:        return "Syntax error";
+      case DTMF_ERROR_UNKNOWN_EVENT: return "Unknown event";
+      case DTMF_ERROR_RANGE:         return "Value out of range";
+      case DTMF_ERROR_TOO_LONG:      return "Too long for a .wav file";
+   }
+   return "Unknown error";
+}
+
+
+/// The radians per sample of a tone at a given frequency
+///
+/// DTMF frequencies at the standard rates come straight out of the
+/// precomputed table.  Anything else is computed.
+static double phase_increment( uint32_t frequency, uint32_t sample_rate ) {
+   int rate_index = dtmf_rate_index( sample_rate );
+   int frequency_index = dtmf_frequency_index( frequency );
+
+   if( rate_index >= 0 && frequency_index >= 0 ) {
+      return DTMF_PHASE_INCREMENT[ rate_index ][ frequency_index ];
+   }
+
+   return 2.0 * M_PI * frequency / sample_rate;
+}
+
+
+/// At time index, return a raw tone sample
+///
+/// @returns A value from -1 to 1
+static inline double generate_tone( uint32_t index, double increment ) {
+   return sin( index * increment );  /// % of duty cycle
+}
+
+
+/// Convert a duration into a number of samples, refusing to overflow
+static dtmf_status ms_to_samples( uint32_t duration_in_ms, uint32_t sample_rate, uint32_t* samples ) {
+   uint64_t result = (uint64_t) duration_in_ms * sample_rate / 1000;
+
+   if( result > UINT32_MAX ) {
+      return DTMF_ERROR_TOO_LONG;
+   }
+
+   *samples = (uint32_t) result;
+   return DTMF_OK;
+}
+
+
+/// Split the next whitespace-delimited token off of *cursor
+///
+/// @returns NULL when there are no more tokens
+static char* next_token( char** cursor ) {
+   char* token = *cursor + strspn( *cursor, " \t\r\n" );
+   if( *token == '\0' ) {
+      *cursor = token;
+      return NULL;
+   }
+
+   char* end = token + strcspn( token, " \t\r\n" );
+   if( *end != '\0' ) {
+      *end++ = '\0';
+   }
+   *cursor = end;
+   return token;
+}
+
+
+/// Parse a decimal number that has to be the whole of text
+///
+/// This is [+-]digits[.digits][e[+-]digits], always with a '.', so it
+/// doesn't depend on the host process's LC_NUMERIC the way strtod() does.
+static dtmf_status parse_number( const char* text, double* value ) {
+   const char* p = text;
+   int negative = ( *p == '-' );
+   if( *p == '-' || *p == '+' ) {
+      p++;
+   }
+
+   uint64_t mantissa = 0;
+   int exponent = 0;   /// Of 10, applied to mantissa
+   int digits   = 0;
+
+   for( ; *p >= '0' && *p <= '9' ; p++, digits++ ) {
+      if( mantissa < UINT64_MAX / 10 ) {
+         mantissa = mantissa * 10 + (uint64_t) ( *p - '0' );
+      } else {
+         exponent++;  /// Past the precision of a double anyway
+      }
+   }
+   if( *p == '.' ) {
+      for( p++ ; *p >= '0' && *p <= '9' ; p++, digits++ ) {
+         if( mantissa < UINT64_MAX / 10 ) {
+            mantissa = mantissa * 10 + (uint64_t) ( *p - '0' );
+            exponent--;
+         }
+      }
+   }
+   if( digits == 0 ) {
+      return DTMF_ERROR_SYNTAX;
+   }
+
+   if( *p == 'e' || *p == 'E' ) {
+      p++;
+      int exponent_sign = ( *p == '-' ) ? -1 : 1;
+      if( *p == '-' || *p == '+' ) {
+         p++;
+      }
+      if( !( *p >= '0' && *p <= '9' ) ) {
+         return DTMF_ERROR_SYNTAX;
+      }
+      int e = 0;
+      for( ; *p >= '0' && *p <= '9' ; p++ ) {
+         if( e < 10000 ) {  /// Far past the range of a double
+            e = e * 10 + ( *p - '0' );
+         }
+      }
+      exponent += exponent_sign * e;
+   }
+   if( *p != '\0' ) {
+      return DTMF_ERROR_SYNTAX;
+   }
+
+   /// Dividing keeps values like 0.08 (8 / 100) correctly rounded
+   double result = (double) mantissa;
+   if( mantissa == 0 ) {
+      result = 0;
+   } else if( exponent < 0 ) {
+      result /= pow( 10.0, -exponent );
+   } else if( exponent > 0 ) {
+      result *= pow( 10.0, exponent );
+   }
+   *value = negative ? -result : result;
+
+   if( !isfinite( *value ) ) {
+      return DTMF_ERROR_RANGE;
+   }
+   return DTMF_OK;
+}
+
+
+/// Parse one key=value option into options
+static dtmf_status parse_option( char* token, struct event_options* options ) {
+   char* value = strchr( token, '=' );
+   if( value == NULL ) {
+      return DTMF_ERROR_SYNTAX;
+   }
+   *value++ = '\0';
+
+   double number;
+   dtmf_status status = parse_number( value, &number );
+   if( status != DTMF_OK ) {
+      return status;
+   }
+
+   /// The checks are written so a NaN fails them
+   if( strcmp( token, "dur" ) == 0 ) {
+      if( !( number >= 0 && number <= UINT32_MAX ) ) return DTMF_ERROR_RANGE;
+      options->duration_in_ms = (uint32_t) number;
+   } else if( strcmp( token, "gap" ) == 0 ) {
+      if( !( number >= 0 && number <= UINT32_MAX ) ) return DTMF_ERROR_RANGE;
+      options->gap_in_ms = (uint32_t) number;
+   } else if( strcmp( token, "amp" ) == 0 ) {
+      if( !( number >= 0 && number <= 1 ) ) return DTMF_ERROR_RANGE;
+      options->amplitude = number;
+   } else if( strcmp( token, "twist" ) == 0 ) {
+      if( !( number >= -DTMF_MAX_TWIST_IN_DB && number <= DTMF_MAX_TWIST_IN_DB ) ) return DTMF_ERROR_RANGE;
+      options->twist_in_db = number;
+   } else if( strcmp( token, "noise" ) == 0 ) {
+      if( !( number >= 0 && number <= 1 ) ) return DTMF_ERROR_RANGE;
+      options->noise = number;
+   } else {
+      return DTMF_ERROR_SYNTAX;
+   }
+
+   return DTMF_OK;
+}
+
+
+/// Is memory[ size ] aligned and big enough to hold a schedule header?
+static int schedule_memory_ok( const void* memory, size_t size ) {
+   return memory != NULL
+       && (uintptr_t) memory % _Alignof( struct dtmf_schedule ) == 0
+       && size >= sizeof( struct dtmf_schedule );
+}
+
+
+size_t dtmf_schedule_size( size_t capacity ) {
+   if( capacity > ( SIZE_MAX - sizeof( struct dtmf_schedule ) ) / sizeof( struct event ) ) {
+      return 0;  /// Too big to ask for
+   }
+   return sizeof( struct dtmf_schedule ) + capacity * sizeof( struct event );
+}
+
+
+dtmf_status dtmf_schedule_init( void* memory, size_t size, uint32_t sample_rate, dtmf_schedule** schedule ) {
+   if( !schedule_memory_ok( memory, size ) || sample_rate == 0 || schedule == NULL ) {
+      return DTMF_ERROR_ARGUMENT;
+   }
+
+   dtmf_schedule* s = memory;
+   s->capacity      = ( size - sizeof( struct dtmf_schedule ) ) / sizeof( struct event );
+   s->count         = 0;
+   s->sample_rate   = sample_rate;
+   s->total_samples = 0;
+
+   *schedule = s;
+   return DTMF_OK;
+}
+
+
+dtmf_status dtmf_schedule_resize( void* memory, size_t size, dtmf_schedule** schedule ) {
+   if( !schedule_memory_ok( memory, size ) || schedule == NULL ) {
+      return DTMF_ERROR_ARGUMENT;
+   }
+
+   dtmf_schedule* s = memory;
+   size_t capacity = ( size - sizeof( struct dtmf_schedule ) ) / sizeof( struct event );
+   if( capacity < s->count ) {
+      return DTMF_ERROR_ARGUMENT;  /// It would lose events
+   }
+   s->capacity = capacity;
+
+   *schedule = s;
+   return DTMF_OK;
+}
+
+
+size_t dtmf_schedule_count( const dtmf_schedule* schedule ) {
+   return ( schedule == NULL ) ? 0 : schedule->count;
+}
+
+
+uint32_t dtmf_schedule_total_samples( const dtmf_schedule* schedule ) {
+   return ( schedule == NULL ) ? 0 : schedule->total_samples;
+}
+
+
+dtmf_status dtmf_schedule_event( const dtmf_schedule* schedule, size_t index, dtmf_event_info* info ) {
+   if( schedule == NULL || index >= schedule->count || info == NULL ) {
+      return DTMF_ERROR_ARGUMENT;
+   }
+
+   const struct event* event = &schedule->events[ index ];
+   info->kind         = event->kind;
+   info->digit        = event->digit;
+   info->frequency[0] = event->frequency[0];
+   info->frequency[1] = event->frequency[1];
+   info->start        = event->start;
+   info->tone_samples = event->tone_samples;
+   info->gap_samples  = event->gap_samples;
+   return DTMF_OK;
+}
+
+
+dtmf_status dtmf_schedule_compile_line( dtmf_schedule* schedule, const char* line, size_t* skipped ) {
+   if( schedule == NULL || line == NULL ) {
+      return DTMF_ERROR_ARGUMENT;
+   }
+
+   size_t unknown_digits = 0;
+   if( skipped != NULL ) {
+      *skipped = 0;
+   }
+
+   char copy[ DTMF_SCHEDULE_LINE_LENGTH ];
+   if( strlen( line ) >= sizeof( copy ) ) {
+      return DTMF_ERROR_SYNTAX;
+   }
+   strcpy( copy, line );
+
+   char* cursor = copy;
+   char* kind = next_token( &cursor );
+   if( kind == NULL || kind[0] == '#' ) {
+      return DTMF_OK;
+   }
+
+   struct event event = { 0 };
+   struct event_options options = {
+       .duration_in_ms = DTMF_DEFAULT_TONE_DURATION_IN_MS
+      ,.gap_in_ms      = 0
+      ,.amplitude      = DTMF_DEFAULT_AMPLITUDE
+      ,.twist_in_db    = 0
+      ,.noise          = 0
+   };
+
+   if( strcmp( kind, "dtmf" ) == 0 ) {
+      event.kind = DTMF_EVENT_DTMF;
+      options.gap_in_ms = DTMF_DEFAULT_INTER_TONE_SILENCE_IN_MS;
+   } else if( strcmp( kind, "tone" ) == 0 ) {
+      event.kind = DTMF_EVENT_TONE;
+   } else if( strcmp( kind, "saw" ) == 0 ) {
+      event.kind = DTMF_EVENT_SAW;
+   } else if( strcmp( kind, "silence" ) == 0 ) {
+      event.kind = DTMF_EVENT_SILENCE;
+   } else if( strcmp( kind, "noise" ) == 0 ) {
+      event.kind = DTMF_EVENT_NOISE;
+   } else {
+      return DTMF_ERROR_UNKNOWN_EVENT;
+   }
+
+   char* argument = NULL;
+   if( event.kind == DTMF_EVENT_DTMF || event.kind == DTMF_EVENT_TONE || event.kind == DTMF_EVENT_NOISE ) {
+      argument = next_token( &cursor );
+      if( argument == NULL ) {
+         return DTMF_ERROR_SYNTAX;
+      }
+   }
+
+   dtmf_status status;
+   for( char* token = next_token( &cursor ) ; token != NULL ; token = next_token( &cursor ) ) {
+      if( ( status = parse_option( token, &options ) ) != DTMF_OK ) {
+         return status;
+      }
+   }
+
+   if( ( status = ms_to_samples( options.duration_in_ms, schedule->sample_rate, &event.tone_samples ) ) != DTMF_OK
+    || ( status = ms_to_samples( options.gap_in_ms,      schedule->sample_rate, &event.gap_samples  ) ) != DTMF_OK ) {
+      return status;
+   }
+   event.noise = (float) options.noise;
+
+   /// Check the whole line before adding anything, so a line is all or nothing
+   size_t events_needed = 1;
+
+   if( event.kind == DTMF_EVENT_DTMF ) {
+      /// Characters that aren't on the keypad (like the - in 555-1212) are skipped
+      for( const char* digit = argument ; *digit != '\0' ; digit++ ) {
+         if( DTMF_KEY_INDEX[ (uint8_t) *digit ] == 0 ) {
+            unknown_digits++;
+         }
+      }
+      events_needed = strlen( argument ) - unknown_digits;
+
+      /// Mixing averages the two tones, then twist scales the column tone
+      event.level[0] = (float) ( options.amplitude / 2 );
+      event.level[1] = (float) ( options.amplitude / 2 * pow( 10.0, options.twist_in_db / 20.0 ) );
+   } else if( event.kind == DTMF_EVENT_TONE ) {
+      double frequency;
+      if( ( status = parse_number( argument, &frequency ) ) != DTMF_OK ) {
+         return status;
+      }
+      if( !( frequency >= 1 && frequency < schedule->sample_rate / 2.0 ) ) {
+         return DTMF_ERROR_RANGE;
+      }
+      event.frequency[0] = (uint32_t) frequency;
+      event.increment[0] = phase_increment( event.frequency[0], schedule->sample_rate );
+      event.level[0]     = (float) options.amplitude;
+   } else if( event.kind == DTMF_EVENT_NOISE ) {
+      double level;
+      if( ( status = parse_number( argument, &level ) ) != DTMF_OK ) {
+         return status;
+      }
+      if( !( level >= 0 && level <= 1 ) ) {
+         return DTMF_ERROR_RANGE;
+      }
+      event.noise = (float) level;
+   }
+
+   if( schedule->capacity - schedule->count < events_needed ) {
+      return DTMF_ERROR_FULL;
+   }
+
+   /// The .wav header can only describe UINT32_MAX bytes, including itself
+   uint64_t length = (uint64_t) event.tone_samples + event.gap_samples;
+   if( schedule->total_samples + length * events_needed > UINT32_MAX - 44 ) {
+      return DTMF_ERROR_TOO_LONG;
+   }
+
+   for( size_t i = 0 ; events_needed > 0 ; i++ ) {
+      if( event.kind == DTMF_EVENT_DTMF ) {
+         uint8_t key = DTMF_KEY_INDEX[ (uint8_t) argument[i] ];
+         if( key == 0 ) {
+            continue;
+         }
+         int row = DTMF_KEY_ROW( key );
+         int col = DTMF_ROWS + DTMF_KEY_COL( key );
+
+         event.digit        = argument[i];
+         event.frequency[0] = DTMF_FREQUENCIES[ row ];
+         event.frequency[1] = DTMF_FREQUENCIES[ col ];
+         event.increment[0] = phase_increment( event.frequency[0], schedule->sample_rate );
+         event.increment[1] = phase_increment( event.frequency[1], schedule->sample_rate );
+      }
+
+      event.start = schedule->total_samples;
+      schedule->total_samples += (uint32_t) length;
+      schedule->events[ schedule->count++ ] = event;
+      events_needed--;
+   }
+
+   if( skipped != NULL ) {
+      *skipped = unknown_digits;
+   }
+   return DTMF_OK;
+}
+
+
+size_t dtmf_synth_size( void ) {
+   return sizeof( struct dtmf_synth );
+}
+
+
+dtmf_status dtmf_synth_init( void* memory, size_t size, const dtmf_schedule* schedule, dtmf_synth** synth ) {
+   if( memory == NULL || (uintptr_t) memory % _Alignof( struct dtmf_synth ) != 0 || size < sizeof( struct dtmf_synth )
+    || schedule == NULL || synth == NULL ) {
+      return DTMF_ERROR_ARGUMENT;
+   }
+
+   dtmf_synth* s = memory;
+   s->schedule = schedule;
+   s->event    = 0;
+   s->index    = 0;
+   s->noise    = NOISE_SEED;
+
+   *synth = s;
+   return DTMF_OK;
+}
+
+
+size_t dtmf_synth_position( const dtmf_synth* synth ) {
+   return ( synth == NULL ) ? 0 : synth->event;
+}
+
+
+/// xorshift32:  A tiny generator that keeps its state in the handle
+///
+/// @returns A value from -1 to 1
+static inline float next_noise( uint32_t* state ) {
+   uint32_t x = *state;
+   x ^= x << 13;
+   x ^= x >> 17;
+   x ^= x << 5;
+   *state = x;
+   return (float) x * ( 2.0f / (float) UINT32_MAX ) - 1.0f;
+}
+
+
+/// Fill raw[] with n samples of an event, starting at index within the event
+///
+/// @returns Values from -1 to 1 (before clipping)
+static void synthesize( const struct event* event, uint32_t index, float* raw, uint32_t n, uint32_t* noise_state ) {
+   /// Split the block into the part with signal and the part in the gap
+   uint32_t tone = ( index < event->tone_samples ) ? event->tone_samples - index : 0;
+   if( tone > n ) {
+      tone = n;
+   }
+
+   switch( event->kind ) {
+      case DTMF_EVENT_DTMF:
+         for( uint32_t i = 0 ; i < tone ; i++ ) {
+            raw[i] = (float) ( event->level[0] * generate_tone( index + i, event->increment[0] )
+                             + event->level[1] * generate_tone( index + i, event->increment[1] ) );
+         }
+         break;
+      case DTMF_EVENT_TONE:
+         for( uint32_t i = 0 ; i < tone ; i++ ) {
+            raw[i] = (float) ( event->level[0] * generate_tone( index + i, event->increment[0] ) );
+         }
+         break;
+      case DTMF_EVENT_SAW:  /// quantize() writes the sawtooth
+      case DTMF_EVENT_SILENCE:
+      case DTMF_EVENT_NOISE:
+         tone = 0;
+         break;
+   }
+
+   for( uint32_t i = tone ; i < n ; i++ ) {
+      raw[i] = 0;
+   }
+
+   if( event->noise > 0 ) {
+      for( uint32_t i = 0 ; i < n ; i++ ) {
+         raw[i] += event->noise * next_noise( noise_state );
+      }
+   }
+}
+
+
+/// Convert n raw samples into linear PCM
+static void quantize( const struct event* event, uint32_t index, const float* raw, uint8_t* pcm, uint32_t n ) {
+   for( uint32_t i = 0 ; i < n ; i++ ) {
+      float s = raw[i];
+      if( !( s >= -1.0f && s <= 1.0f ) ) {  /// Clip, and turn a NaN into silence
+         s = ( s > 1.0f ) ? 1.0f : ( s < -1.0f ) ? -1.0f : 0.0f;
+      }
+      pcm[i] = (uint8_t) ( PCM_8_BIT_SILENCE + s * PCM_8_BIT_SILENCE );
+   }
+
+   /// The sawtooth is already PCM, so it bypasses the conversion
+   if( event->kind == DTMF_EVENT_SAW ) {
+      for( uint32_t i = 0 ; i < n && index + i < event->tone_samples ; i++ ) {
+         pcm[i] = ( index + i ) % 256;
+      }
+   }
+}
+
+
+dtmf_status dtmf_synth_render( dtmf_synth* synth, uint8_t* pcm, size_t capacity, size_t* rendered ) {
+   if( synth == NULL || ( pcm == NULL && capacity > 0 ) || rendered == NULL ) {
+      return DTMF_ERROR_ARGUMENT;
+   }
+
+   const dtmf_schedule* schedule = synth->schedule;
+   float  raw[ RENDER_BLOCK_SIZE ];
+   size_t fill = 0;
+
+   while( fill < capacity && synth->event < schedule->count ) {
+      const struct event* event = &schedule->events[ synth->event ];
+      uint32_t length = event->tone_samples + event->gap_samples;
+
+      if( synth->index >= length ) {
+         synth->event++;
+         synth->index = 0;
+         continue;
+      }
+
+      uint32_t n = length - synth->index;
+      if( n > RENDER_BLOCK_SIZE ) {
+         n = RENDER_BLOCK_SIZE;
+      }
+      if( n > capacity - fill ) {
+         n = (uint32_t) ( capacity - fill );
+      }
+
+      synthesize( event, synth->index, raw, n, &synth->noise );
+      quantize( event, synth->index, raw, pcm + fill, n );
+
+      fill         += n;
+      synth->index += n;
+   }
+
+   /// Step past a finished event, so event tells the caller how far we are
+   while( synth->event < schedule->count
+       && synth->index >= schedule->events[ synth->event ].tone_samples + schedule->events[ synth->event ].gap_samples ) {
+      synth->event++;
+      synth->index = 0;
+   }
+
+   *rendered = fill;
+   return DTMF_OK;
+}
@@ -4,6 +4,14 @@
 //
 /// Generate a .wav file containing DTMF dialing tones
 ///
+/// What goes into the file is described by a schedule:  A text file with
+/// one event (DTMF digits, a tone, silence, noise...) per line.  See
+/// dtmf_schedule_compile_line() for the format.  The schedule is compiled
+/// into a flat array of events before anything is rendered, so the length
+/// of the file is known before its header is written.
+///
+/// The synthesis itself is in the dtmf library.  This is just a front end.
+///
 /// @see https://docs.fileformat.com/audio/wav/
 ///
 /// @file main.c
@@ -17,8 +25,11 @@
 #include <stdlib.h>  // For EXIT_SUCCESS
 #include <assert.h>  // For assert()
 #include <stdint.h>  // For fixed-length ints
-#include <math.h>    // For sin()
-#include <string.h>  // For strlen()
+#include <string.h>  // For strcmp()
+#include <getopt.h>  // For getopt()
+
+#include "dtmf.h"        // For dtmf_schedule_compile_line(), dtmf_synth_render(), etc.
+#include "instrument.h"  // For INSTR_BEGIN(), INSTR_END(), etc.
 
 #define PROGRAM_NAME "ee469_lab01_dtmf_wav_gen"
 #define FILENAME     "/home/mark/src/tmp/blob.wav"
@@ -30,25 +41,13 @@
                                    *   2 - 8 bit stereo/16 bit mono    *
                                    *   4 - 16 bit stereo               */
 #define BITS_PER_SAMPLE     8     /* 256 possible values               */
-#define DTMF_TONE_DURATION_IN_MS      200 /* Duration in milliseconds  */
-#define DTMF_INTER_TONE_SILENCE_IN_MS 100 /* The pause between each DTMF tone */
-#define AMPLITUDE           0.8   /* Max amplitude of signal, relative *
-                                   * to the maximum scale              */
 
-#define PCM_8_BIT_SILENCE 127     /* Silence is 127                    */
+#define RENDER_BLOCK_SIZE    4096 /* Samples rendered per fwrite()     */
 
-#define DTMF_ROW_1        697 /* Hz */
-#define DTMF_ROW_2        770 /* Hz */
-#define DTMF_ROW_3        852 /* Hz */
-#define DTMF_ROW_4        941 /* Hz */
 
-#define DTMF_COL_1       1209 /* Hz */
-#define DTMF_COL_2       1336 /* Hz */
-#define DTMF_COL_3       1477 /* Hz */
-#define DTMF_COL_4       1633 /* Hz */
+static const char *gFilename = FILENAME;  /// The .wav file to write
 
-
-static FILE *gFile = NULL;           /// Global file pointer to FILENAME
+static FILE *gFile = NULL;           /// Global file pointer to gFilename
 
 static uint32_t gPCM_data_size = 0;  /// Global counter for the number of
                                      /// bytes written
@@ -61,10 +60,13 @@ static uint32_t gPCM_data_size = 0;  /// Global counter for the number of
 size_t fwrite_ex( const void *ptr, size_t size, size_t members, FILE *stream ) {
    size_t expected_size = size * members;
 
+   INSTR_BEGIN( t );
    size_t return_value = fwrite( ptr, size, members, stream );
+   INSTR_END( INSTR_STAGE_WRITE, t );
+   INSTR_COUNT( INSTR_COUNT_BYTES_WRITTEN, return_value * size );
 
    if( expected_size != return_value ) {
-      printf( PROGRAM_NAME ": Unable to stream PCM to [%s].  Exiting.\n", FILENAME );
+      printf( PROGRAM_NAME ": Unable to stream PCM to [%s].  Exiting.\n", gFilename );
       exit( EXIT_FAILURE );
    }
 
@@ -74,14 +76,13 @@ size_t fwrite_ex( const void *ptr, size_t size, size_t members, FILE *stream ) {
 
 /// Open the .wav file and write the header.
 ///
-/// There will be fields in the header that will be updated when the file
-/// is closed.
-void open_audio_file() {
+/// @param data_size The number of bytes of PCM that will follow the header
+void open_audio_file( uint32_t data_size ) {
    assert( gFile == NULL );
 
-   gFile = fopen( FILENAME, "w+" );
+   gFile = fopen( gFilename, "w" );
    if( gFile == NULL ) {
-      printf(PROGRAM_NAME ": Could not open file [%s].  Exiting.\n", FILENAME );
+      printf(PROGRAM_NAME ": Could not open file [%s].  Exiting.\n", gFilename );
       exit( EXIT_FAILURE );
    }
 
@@ -92,8 +93,7 @@ void open_audio_file() {
    /// Marks file as a RIFF file
    fwrite_ex( "RIFF", 1, 4, gFile );
 
-   uint32_t file_size = 44 + gPCM_data_size;  // 44 is total size of the entire header
-                                              // This gets overwritten later
+   uint32_t file_size = 44 + data_size;  // 44 is total size of the entire header
 
    fwrite_ex( &file_size, 1, sizeof(uint32_t), gFile );  /// File size
 
@@ -124,355 +124,251 @@ void open_audio_file() {
 
    fwrite_ex( "data", 1, 4, gFile );   /// Marks the beginning of the data section
 
-   fwrite_ex( &gPCM_data_size, 1, sizeof(uint32_t), gFile );
+   fwrite_ex( &data_size, 1, sizeof(uint32_t), gFile );
 }
 
 
-/// At time index, return a raw tone sample at a given frequency
-///
-/// @param frequency The tone's frequency in Hz
-/// @param index The time reference
-///
-/// @returns A value from -1 to 1
-double generate_tone( uint32_t index, uint32_t frequency ) {
-   assert( frequency != 0 );
+/// The schedule to render when one isn't given with -s.
+static const char* DEFAULT_SCHEDULE[] = {
+    "dtmf    0123456789*#abcd"
+   ,"tone    1209  dur=2000"   // 1209Hz tone for 2 seconds
+   ,"saw           dur=2000"   // Sawtooth for 2 seconds
+   ,"silence       dur=2000"   // Silence for 2 seconds
+   ,"noise   0.08  dur=2000"   // Noise for 2 seconds
+   ,NULL
+};
 
-   double cadence = (double) SAMPLE_RATE / frequency / 2.0 / M_PI;
 
-   return sin( index / cadence );  /// % of duty cycle
-}
+/// Room for this many events is allocated up front.  It doubles as needed.
+#define INITIAL_EVENT_CAPACITY 64
 
+static void*          gScheduleMemory   = NULL;  /// From malloc(), holds gSchedule
+static dtmf_schedule* gSchedule         = NULL;
+static size_t         gScheduleCapacity = 0;     /// Events gSchedule has room for
 
-/// Mix two tones by averaging them together.  In linear digital audio,
-/// this has the effect of attenuating the volume of each tone by 1/2.
-///
-/// @param f1 The value of the 1st tone (from -1 to 1)
-/// @param f2 The value of the 2nd tone (from -1 to 1)
-///
-/// @return The mixed signal (from -1 to 1)
-double mix_tones( double f1, double f2 ) {
-   assert( f1 >= -1 && f1 <= 1);
-   assert( f2 >= -1 && f2 <= 1);
-
-   return ( (f1 + f2) / 2 );  /// Average the two samples
-}
 
+/// Allocate an empty schedule with room for capacity events
+void new_schedule( size_t capacity ) {
+   size_t size = dtmf_schedule_size( capacity );
+   void* memory = ( size == 0 ) ? NULL : malloc( size );
 
-/// Generate a DTMF signal for DURATION_IN_MS and write it to the .wav file
-///
-/// @param DTMF_digit as an ASII character.  Valid values are:
-///        0 through 9, *, # and a through d (case insensitive).
-///        It will skip an unrecognized DTMF_digit
-void write_DTMF_tone( char DTMF_digit ) {
-   assert( gFile != NULL );   /// Assume gFile is open
-
-   uint32_t DTMF_row = 0;
-   uint32_t DTMF_column = 0;
-
-   switch( DTMF_digit ) {
-      case '0':
-         DTMF_row = DTMF_ROW_4;
-         DTMF_column = DTMF_COL_2;
-         break;
-      case '1':
-         DTMF_row = DTMF_ROW_1;
-         DTMF_column = DTMF_COL_1;
-         break;
-      case '2':
-         DTMF_row = DTMF_ROW_1;
-         DTMF_column = DTMF_COL_2;
-         break;
-      case '3':
-         DTMF_row = DTMF_ROW_1;
-         DTMF_column = DTMF_COL_3;
-         break;
-      case '4':
-         DTMF_row = DTMF_ROW_2;
-         DTMF_column = DTMF_COL_1;
-         break;
-      case '5':
-         DTMF_row = DTMF_ROW_2;
-         DTMF_column = DTMF_COL_2;
-         break;
-      case '6':
-         DTMF_row = DTMF_ROW_2;
-         DTMF_column = DTMF_COL_3;
-         break;
-      case '7':
-         DTMF_row = DTMF_ROW_3;
-         DTMF_column = DTMF_COL_1;
-         break;
-      case '8':
-         DTMF_row = DTMF_ROW_3;
-         DTMF_column = DTMF_COL_2;
-         break;
-      case '9':
-         DTMF_row = DTMF_ROW_3;
-         DTMF_column = DTMF_COL_3;
-         break;
-      case '*':
-         DTMF_row = DTMF_ROW_4;
-         DTMF_column = DTMF_COL_1;
-         break;
-      case '#':
-         DTMF_row = DTMF_ROW_4;
-         DTMF_column = DTMF_COL_3;
-         break;
-      case 'A':
-      case 'a':
-         DTMF_row = DTMF_ROW_1;
-         DTMF_column = DTMF_COL_4;
-         break;
-      case 'B':
-      case 'b':
-         DTMF_row = DTMF_ROW_2;
-         DTMF_column = DTMF_COL_4;
-         break;
-      case 'C':
-      case 'c':
-         DTMF_row = DTMF_ROW_3;
-         DTMF_column = DTMF_COL_4;
-         break;
-      case 'D':
-      case 'd':
-         DTMF_row = DTMF_ROW_4;
-         DTMF_column = DTMF_COL_4;
-         break;
-      // No default case statement... The next statement does the error checking
+   if( memory == NULL || dtmf_schedule_init( memory, size, SAMPLE_RATE, &gSchedule ) != DTMF_OK ) {
+      printf( PROGRAM_NAME ": Out of memory.  Exiting.\n" );
+      exit( EXIT_FAILURE );
    }
+   gScheduleMemory   = memory;
+   gScheduleCapacity = capacity;
+}
 
-   if( DTMF_row == 0 || DTMF_column == 0) {
-      printf( PROGRAM_NAME ": Unknown DTMF tone character [%c].  Skipping.\n", DTMF_digit );
-      return;
-   }
 
-   assert( DTMF_row > 0 );
-   assert( DTMF_column > 0 );
+/// Double the room gSchedule has for events
+void grow_schedule() {
+   size_t capacity = gScheduleCapacity * 2;
+   size_t size = dtmf_schedule_size( capacity );
+   void* memory = ( size == 0 ) ? NULL : realloc( gScheduleMemory, size );
 
-   uint32_t index = 0;
-   uint32_t samples = (uint32_t) (( (double) DTMF_TONE_DURATION_IN_MS / 1000.0) * SAMPLE_RATE);
+   if( memory == NULL || dtmf_schedule_resize( memory, size, &gSchedule ) != DTMF_OK ) {
+      printf( PROGRAM_NAME ": Out of memory.  Exiting.\n" );
+      exit( EXIT_FAILURE );
+   }
+   gScheduleMemory   = memory;
+   gScheduleCapacity = capacity;
+}
 
-   while( index < samples ) {
-      double s;  // Raw sound as -1 to 1
-      s = mix_tones( generate_tone( index, DTMF_row ), generate_tone( index, DTMF_column ) );
 
-      // Convert -1 to 1 into a linear PCM representation
-      uint8_t PcmSample = (uint8_t) (PCM_8_BIT_SILENCE + ( s * PCM_8_BIT_SILENCE * AMPLITUDE ));
+/// Compile one line into gSchedule, growing it as needed
+///
+/// Exits with a message naming the line if it's bad.
+void compile_line( const char* line, uint32_t line_number ) {
+   dtmf_status status;
+   size_t skipped;
 
-      // Write PcmSample to the .wav file
-      fwrite_ex( &PcmSample, 1, 1, gFile );
+   while( ( status = dtmf_schedule_compile_line( gSchedule, line, &skipped ) ) == DTMF_ERROR_FULL ) {
+      grow_schedule();
+   }
 
-      gPCM_data_size++;
-      index++;
+   if( status != DTMF_OK ) {
+      printf( PROGRAM_NAME ": Schedule line %u: %s.  Exiting.\n", line_number, dtmf_strerror( status ) );
+      exit( EXIT_FAILURE );
    }
 
-   printf( PROGRAM_NAME ": Generated DTMF digit [%c] at tones [%d] and [%d].\n", DTMF_digit, DTMF_row, DTMF_column );
+   if( skipped > 0 ) {
+      printf( PROGRAM_NAME ": Schedule line %u: Skipped %zu unknown DTMF tone character(s).\n", line_number, skipped );
+   }
 }
 
 
-/// Write silence to the .wav file
-void write_silence( uint32_t duration_in_ms ) {
-   uint32_t index = 0;
-   uint32_t samples = (uint32_t) ( (float) duration_in_ms * SAMPLE_RATE / 1000.0f );
-
-   while( index < samples ) {
-      uint8_t PcmSample = (uint8_t) PCM_8_BIT_SILENCE;  // Silence
-
-      fwrite_ex( &PcmSample, 1, 1, gFile );
-
-      gPCM_data_size++;
-      index++;
+/// Compile a schedule file (or stdin, if filename is "-")
+void compile_schedule_file( const char* filename ) {
+   FILE* file = ( strcmp( filename, "-" ) == 0 ) ? stdin : fopen( filename, "r" );
+   if( file == NULL ) {
+      printf( PROGRAM_NAME ": Could not open schedule [%s].  Exiting.\n", filename );
+      exit( EXIT_FAILURE );
    }
-}
 
+   char line[ DTMF_SCHEDULE_LINE_LENGTH ];
+   uint32_t line_number = 0;
 
-/// Write white (random) noise to the .wav file
-///
-/// @param noise_percentage A value from 0 to 1, representing how much noise
-///                         to produce.
-/// @param duration_in_ms   Duration of the signal
-void write_noise( float noise_percentage, uint32_t duration_in_ms ) {
-   uint32_t index = 0;
-   uint32_t samples = (uint32_t) ( (float) duration_in_ms * SAMPLE_RATE / 1000.0f );
+   while( fgets( line, sizeof( line ), file ) != NULL ) {
+      line_number++;
 
-   while( index < samples ) {
-      uint8_t PcmSample = (uint8_t) (((rand() % PCM_8_BIT_SILENCE) * noise_percentage) + PCM_8_BIT_SILENCE );
+      /// A line that didn't fit has no newline (unless it's the last line)
+      if( strchr( line, '\n' ) == NULL && !feof( file ) ) {
+         printf( PROGRAM_NAME ": Schedule line %u: Longer than %d characters.  Exiting.\n", line_number, DTMF_SCHEDULE_LINE_LENGTH - 2 );
+         exit( EXIT_FAILURE );
+      }
 
-      fwrite_ex( &PcmSample, 1, 1, gFile );
+      compile_line( line, line_number );
+   }
 
-      gPCM_data_size++;
-      index++;
+   if( file != stdin ) {
+      fclose( file );
    }
 }
 
 
-/// Write a sawtooth signal (0, 1, 2, ... 254, 255, 0, 1, 2...) to the .wav file
-///
-/// It's a fixed frequency that depends on the sampling rate and bit depth
-///
-/// This is mostly used for diagnostics
-///
-/// @param duration_in_ms Milliseconds of signal
-///
-void write_sawtooth_tone( uint32_t duration_in_ms ) {
-   assert( gFile != NULL );
-
-   uint32_t index = 0;
-   uint32_t samples = (uint32_t) ( (float) duration_in_ms * SAMPLE_RATE / 1000.0f );
+/// Compile the built-in DEFAULT_SCHEDULE
+void compile_default_schedule() {
+   for( uint32_t i = 0 ; DEFAULT_SCHEDULE[i] != NULL ; i++ ) {
+      compile_line( DEFAULT_SCHEDULE[i], i + 1 );
+   }
+}
 
-   while( index < samples ) {
-      uint8_t PcmSample = index % 256;
 
-      fwrite_ex( &PcmSample, 1, 1, gFile );
+/// Print a progress message for each DTMF digit that has been rendered
+void print_events( const dtmf_schedule* schedule, size_t from, size_t to ) {
+   dtmf_event_info event;
 
-      gPCM_data_size++;
-      index++;
+   for( size_t e = from ; e < to ; e++ ) {
+      if( dtmf_schedule_event( schedule, e, &event ) == DTMF_OK && event.kind == DTMF_EVENT_DTMF ) {
+         printf( PROGRAM_NAME ": Generated DTMF digit [%c] at tones [%d] and [%d].\n", event.digit, event.frequency[0], event.frequency[1] );
+      }
    }
 }
 
 
-/// Write a sinusoidal signal to the .wav file
-///
-/// This is mostly used for diagnostics
-///
-/// @param frequency      Frequency of the tone
-/// @param duration_in_ms Duration of the tone in milliseconds
-void write_sinwave_tone( uint32_t frequency, uint32_t duration_in_ms ) {
+/// Render the whole schedule to the .wav file in one streaming pass,
+/// RENDER_BLOCK_SIZE bytes per fwrite()
+void render_schedule( const dtmf_schedule* schedule ) {
    assert( gFile != NULL );
-   assert( frequency != 0 );
 
-   uint32_t index = 0;
-   uint32_t samples = (uint32_t) ( (float) duration_in_ms * SAMPLE_RATE / 1000.0f );
+   dtmf_synth* synth;
+   void* synth_memory = malloc( dtmf_synth_size() );
+   if( synth_memory == NULL || dtmf_synth_init( synth_memory, dtmf_synth_size(), schedule, &synth ) != DTMF_OK ) {
+      printf( PROGRAM_NAME ": Out of memory.  Exiting.\n" );
+      exit( EXIT_FAILURE );
+   }
+
+   uint8_t pcm[ RENDER_BLOCK_SIZE ];
+   size_t  reported = 0;  /// Events that have had their progress message
+   size_t  n;
+
+   for( ;; ) {
+      INSTR_BEGIN( t_render );
+      dtmf_status status = dtmf_synth_render( synth, pcm, sizeof( pcm ), &n );
+      INSTR_END( INSTR_STAGE_RENDER, t_render );
+      if( status != DTMF_OK ) {
+         printf( PROGRAM_NAME ": Unable to render: %s.  Exiting.\n", dtmf_strerror( status ) );
+         exit( EXIT_FAILURE );
+      }
+      if( n == 0 ) {
+         break;
+      }
+      INSTR_COUNT( INSTR_COUNT_SAMPLES, n );
 
-   while( index < samples ) {
-      double s = generate_tone( index, frequency );  // Raw sound
-      uint8_t PcmSample = (uint8_t) (PCM_8_BIT_SILENCE + ( s * PCM_8_BIT_SILENCE * AMPLITUDE ));
+      fwrite_ex( pcm, 1, n, gFile );
+      gPCM_data_size += n;
 
-      fwrite_ex( &PcmSample, 1, sizeof(uint8_t), gFile );
+      print_events( schedule, reported, dtmf_synth_position( synth ) );
+      reported = dtmf_synth_position( synth );
 
-      gPCM_data_size++;
-      index++;
+      INSTR_POLL();
    }
+
+   print_events( schedule, reported, dtmf_schedule_count( schedule ) );
+
+   assert( gPCM_data_size == dtmf_schedule_total_samples( schedule ) );
+
+   free( synth_memory );
 }
 
 
 /// Close the .wav file
 ///
-/// Seek back to the header and update 2 fields
+/// The header was written with the final sizes, so there's nothing to
+/// seek back and fix.
 void close_audio_file() {
    assert( gFile != NULL );
 
-   fseek( gFile, 4, SEEK_SET );  /// Seek to the File Size field
-
-   uint32_t file_size = 44 + gPCM_data_size;  // 44 is the actual size of the header
-
-   fwrite_ex( &file_size, 1, sizeof(uint32_t), gFile );         /// File size
-
-   fseek( gFile, 42, SEEK_SET );  /// Seek to the Size of the Data Section field
-
-   fwrite_ex( &gPCM_data_size, 1, sizeof(uint32_t), gFile );
-
-   if( gFile != NULL ) {
-      fclose( gFile );
-      gFile = NULL;
+   if( fclose( gFile ) != 0 ) {
+      printf( PROGRAM_NAME ": Unable to stream PCM to [%s].  Exiting.\n", gFilename );
+      exit( EXIT_FAILURE );
    }
+   gFile = NULL;
 }
 
 
-/// Process dtmf_string and write the digits to a .wav file.  Separate each
-/// digit by some silence.
-void write_dtmf_digits( char* dtmf_string ) {
-   if( dtmf_string == NULL ) {
-      printf( PROGRAM_NAME ": Empty DTMF String.  Nothing to do.\n" );
-      return;
-   }
-
-   for( int i = 0 ; i < strlen( dtmf_string ) ; i++ ) {
-      write_DTMF_tone( dtmf_string[i] );
-      write_silence( DTMF_INTER_TONE_SILENCE_IN_MS );
-   }
+void print_help() {
+   printf(
+           "Usage: " PROGRAM_NAME " [-s <schedule>] [-o <file>]\n"
+           "\n"
+           "\t-s <file>\tRead the schedule from file (- for STDIN)\n"
+           "\t\t\t(default: every DTMF digit, then a tone, sawtooth, silence and noise)\n"
+           "\t-o <file>\tWrite the .wav to file (default " FILENAME ")\n"
+           "\t-?\t\tPrint help\n"
+           "\n"
+           "Schedule lines:  <kind> [<argument>] [key=value ...]\n"
+           "\tdtmf <digits> | tone <Hz> | saw | silence | noise <0..1>\n"
+           "\tdur=<ms> gap=<ms> amp=<0..1> twist=<dB> noise=<0..1>\n"
+           "\n"
+           "Example:\n"
+           "\tdtmf 8085551212 dur=80 gap=60 twist=-2 noise=0.05\n"
+           "\tsilence dur=1000\n"
+           "\ttone 440 dur=500 amp=0.5\n"
+   );
 }
 
 
-float goertzel_magnitude( int numSamples, float TARGET_FREQUENCY, int SAMPLING_RATE, float* data ) {
-   int     k,i;
-   float   floatnumSamples;
-   float   omega,sine,cosine,coeff,q0,q1,q2,magnitude,real,imag;
-
-   float   scalingFactor = numSamples / 2.0;
-
-   floatnumSamples = (float) numSamples;
-   k = (int) (0.5 + ((floatnumSamples * TARGET_FREQUENCY) / (float)SAMPLING_RATE));
-   omega = (2.0 * M_PI * k) / floatnumSamples;
-   sine = sin(omega);
-   cosine = cos(omega);
-   coeff = 2.0 * cosine;
-   q0=0;
-   q1=0;
-   q2=0;
-
-   for(i=0; i<numSamples; i++)
-   {
-      q0 = coeff * q1 - q2 + data[i];
-      q2 = q1;
-      q1 = q0;
+/// Program entry point
+int main( int argc, char* argv[] ) {
+   const char* schedule_filename = NULL;
+
+   int opt;
+   while( ( opt = getopt( argc, argv, "?s:o:" ) ) != -1 ) {
+      switch( opt ) {
+         case 's':
+            schedule_filename = optarg;
+            break;
+         case 'o':
+            gFilename = optarg;
+            break;
+         case '?':
+         default:
+            print_help();
+            return EXIT_SUCCESS;
+      }
    }
 
-   // calculate the real and imaginary results
-   // scaling appropriately
-   real = (q1 * cosine - q2) / scalingFactor;
-   imag = (q1 * sine) / scalingFactor;
-
-   magnitude = sqrtf(real*real + imag*imag);
-   //phase = atan(imag/real)
-   return magnitude;
-}
-
-
-/// TODO TODO
-///
-/// This is mostly used for diagnostics
-///
-/// @param frequency      Frequency of the tone
-/// @param duration_in_ms Duration of the tone in milliseconds
-void test_goertzel() {
-   assert( gFile != NULL );
-
-   uint32_t frequency = 1000;
-   uint32_t duration_in_ms = 100;
+   printf( PROGRAM_NAME ": Starting.  Writing to [%s]\n", gFilename );
 
-   uint32_t index = 0;
-   uint32_t samples = (uint32_t) (((double) duration_in_ms / 1000.0) * SAMPLE_RATE);
+   INSTR_INIT( PROGRAM_NAME );
 
-   uint8_t toneArray[ SAMPLE_RATE/1000 * duration_in_ms ];
+   new_schedule( INITIAL_EVENT_CAPACITY );
 
-   while( index < samples ) {
-      double s = generate_tone( index, frequency );  // Raw sound
-      uint8_t PcmSample = (uint8_t) (PCM_8_BIT_SILENCE + ( s * PCM_8_BIT_SILENCE * AMPLITUDE ));
-
-      toneArray[index] = PcmSample;
-
-      index++;
+   if( schedule_filename == NULL ) {
+      compile_default_schedule();
+   } else {
+      compile_schedule_file( schedule_filename );
    }
-}
 
+   open_audio_file( dtmf_schedule_total_samples( gSchedule ) );
 
-/// Program entry point
-int main() {
-   printf( PROGRAM_NAME ": Starting.  Writing to [%s]\n", FILENAME );
-
-   open_audio_file();
-
-   write_dtmf_digits( "0123456789*#abcd" );
-   write_sinwave_tone( 1209, 2000 );  // 1209Hz tone for 2 seconds
-   write_sawtooth_tone( 2000 );  // Sawtooth for 2 seconds
-   write_silence( 2000 );  // Silence for 2 seconds
-   write_noise( 0.08, 2000 );  // Noise for 2 seconds
-
-   //test_goertzel();
+   render_schedule( gSchedule );
 
    close_audio_file();
 
+   free( gScheduleMemory );
+
    printf( PROGRAM_NAME ": Ends successfully\n" );
    return EXIT_SUCCESS;
 }
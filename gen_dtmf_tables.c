@@ -0,0 +1,112 @@
+///////////////////////////////////////////////////////////////////////////////
+//          University of Hawaii, College of Engineering
+//          ee469_lab01_dtmf_wav_gen - EE 469 - Fall 2022
+//
+/// Generate dtmf_tables.h at build time
+///
+/// For every DTMF frequency at every rate in DTMF_TABLE_SAMPLE_RATES, this
+/// writes the phase increment used by the generator and the Goertzel terms
+/// used by the detector.  It also writes the detector's decimating filter
+/// for every factor in DTMF_DECIMATOR_TABLE_FACTORS.  So neither program
+/// does any trig during setup at the standard rates.
+///
+/// Usage:  gen_dtmf_tables <output.h>
+///
+/// @file gen_dtmf_tables.c
+/// @version 1.0
+///
+/// @author Mark Nelson <marknels@hawaii.edu>
+/// @date   04_Oct_2022
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>   // For fprintf(), fopen(), etc.
+#include <stdlib.h>  // For EXIT_SUCCESS
+#include <math.h>    // For sin() and cos()
+
+#include "dtmf_keypad.h"
+#include "dtmf_decimator.h"
+
+#define PROGRAM_NAME "gen_dtmf_tables"
+
+
+int main( int argc, char* argv[] ) {
+   if( argc != 2 ) {
+      fprintf( stderr, "Usage: " PROGRAM_NAME " <output.h>\n" );
+      return EXIT_FAILURE;
+   }
+
+   FILE* out = fopen( argv[1], "w" );
+   if( out == NULL ) {
+      fprintf( stderr, PROGRAM_NAME ": Could not open file [%s].  Exiting.\n", argv[1] );
+      return EXIT_FAILURE;
+   }
+
+   fprintf( out,
+            "/// @file dtmf_tables.h\n"
+            "///\n"
+            "/// Generated by " PROGRAM_NAME ".  Do not edit.\n"
+            "///\n"
+            "/// Indexed by [ dtmf_rate_index() ][ dtmf_frequency_index() ]\n"
+            "\n"
+            "#pragma once\n"
+            "\n"
+            "#include \"dtmf_keypad.h\"\n"
+            "#include \"dtmf_decimator.h\"\n"
+            "\n" );
+
+   fprintf( out, "/// 2 * pi * frequency / sample_rate  (radians per sample)\n" );
+   fprintf( out, "static const double DTMF_PHASE_INCREMENT[ DTMF_TABLE_RATE_COUNT ][ DTMF_FREQUENCY_COUNT ] = {\n" );
+   for( int r = 0 ; r < DTMF_TABLE_RATE_COUNT ; r++ ) {
+      fprintf( out, "   %c{", r == 0 ? ' ' : ',' );
+      for( int f = 0 ; f < DTMF_FREQUENCY_COUNT ; f++ ) {
+         double omega = 2.0 * M_PI * DTMF_FREQUENCIES[f] / DTMF_TABLE_SAMPLE_RATES[r];
+         fprintf( out, "%s%.17g", f == 0 ? " " : ", ", omega );
+      }
+      fprintf( out, " }  /* %u Hz */\n", DTMF_TABLE_SAMPLE_RATES[r] );
+   }
+   fprintf( out, "};\n\n" );
+
+   fprintf( out, "/// { cos( omega ), sin( omega ), 2 * cos( omega ) }\n" );
+   fprintf( out, "static const struct goertzel_coeff DTMF_GOERTZEL_COEFF[ DTMF_TABLE_RATE_COUNT ][ DTMF_FREQUENCY_COUNT ] = {\n" );
+   for( int r = 0 ; r < DTMF_TABLE_RATE_COUNT ; r++ ) {
+      fprintf( out, "   %c{  /* %u Hz */\n", r == 0 ? ' ' : ',', DTMF_TABLE_SAMPLE_RATES[r] );
+      for( int f = 0 ; f < DTMF_FREQUENCY_COUNT ; f++ ) {
+         double omega = 2.0 * M_PI * DTMF_FREQUENCIES[f] / DTMF_TABLE_SAMPLE_RATES[r];
+         fprintf( out, "      %c{ %.9ef, %.9ef, %.9ef }\n"
+                  ,f == 0 ? ' ' : ','
+                  ,cos( omega ), sin( omega ), 2.0 * cos( omega ) );
+      }
+      fprintf( out, "    }\n" );
+   }
+   fprintf( out, "};\n\n" );
+
+   fprintf( out, "/// The decimating lowpass, indexed by dtmf_decimator_factor_index().\n" );
+   fprintf( out, "/// Each has factor * DTMF_DECIMATOR_TAPS_PER_PHASE taps.\n" );
+   fprintf( out, "static const float DTMF_DECIMATOR_FIR[ DTMF_DECIMATOR_TABLE_FACTOR_COUNT ][ DTMF_DECIMATOR_TABLE_MAX_TAPS ] = {\n" );
+   for( int f = 0 ; f < DTMF_DECIMATOR_TABLE_FACTOR_COUNT ; f++ ) {
+      int   factor = DTMF_DECIMATOR_TABLE_FACTORS[f];
+      int   taps   = factor * DTMF_DECIMATOR_TAPS_PER_PHASE;
+      float h[ DTMF_DECIMATOR_TABLE_MAX_TAPS ];
+
+      if( taps > DTMF_DECIMATOR_TABLE_MAX_TAPS ) {
+         fprintf( stderr, PROGRAM_NAME ": Factor %d needs more than %d taps.  Exiting.\n", factor, DTMF_DECIMATOR_TABLE_MAX_TAPS );
+         return EXIT_FAILURE;
+      }
+      dtmf_decimator_design( factor, h );
+
+      fprintf( out, "   %c{  /* Factor %d */\n", f == 0 ? ' ' : ',', factor );
+      for( int i = 0 ; i < taps ; i++ ) {
+         fprintf( out, "%s%.9ef", i % 4 == 0 ? "      " : " ", h[i] );
+         fprintf( out, "%s", i + 1 == taps ? "\n" : ( i % 4 == 3 ) ? ",\n" : "," );
+      }
+      fprintf( out, "    }\n" );
+   }
+   fprintf( out, "};\n" );
+
+   if( fclose( out ) != 0 ) {
+      fprintf( stderr, PROGRAM_NAME ": Could not write file [%s].  Exiting.\n", argv[1] );
+      return EXIT_FAILURE;
+   }
+
+   return EXIT_SUCCESS;
+}
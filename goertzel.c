@@ -4,7 +4,9 @@
 //         University of Hawaii, College of Engineering
 //         ee469_lab01_dtmf_wav_gen - EE 205 - Spr 2023
 //
-/// Lorem ipsum dolor sit amet
+/// Compute the magnitude of tones in a raw audio stream (Goertzel algorithm)
+///
+/// The detection itself is in the dtmf library.  This is just a front end.
 ///
 /// @file goertzel.c
 /// @version 1.0
@@ -17,42 +19,12 @@
 #include <math.h>
 #include <getopt.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
 
+#include "dtmf.h"
+#include "instrument.h"
 
-float goertzel_mag(int numSamples,float TARGET_FREQUENCY,int SAMPLING_RATE, float* data)
-{
-   int     k,i;
-   float   floatnumSamples;
-   float   omega,sine,cosine,coeff,q0,q1,q2,magnitude,real,imag;
-
-   float   scalingFactor = numSamples / 2.0;
-
-   floatnumSamples = (float) numSamples;
-   k = (int) (0.5 + ((floatnumSamples * TARGET_FREQUENCY) / (float)SAMPLING_RATE));
-   omega = (2.0 * M_PI * k) / floatnumSamples;
-   sine = sin(omega);
-   cosine = cos(omega);
-   coeff = 2.0 * cosine;
-   q0=0;
-   q1=0;
-   q2=0;
-
-   for(i=0; i<numSamples; i++)
-   {
-      q0 = coeff * q1 - q2 + data[i];
-      q2 = q1;
-      q1 = q0;
-   }
-
-   // calculate the real and imaginary results
-   // scaling appropriately
-   real = (q1 * cosine - q2) / scalingFactor;
-   imag = (q1 * sine) / scalingFactor;
-
-   magnitude = sqrtf(real*real + imag*imag);
-   //phase = atan(imag/real)
-   return magnitude;
-}
 
 void print_help(char ** argv) {
    printf(
@@ -67,10 +39,10 @@ void print_help(char ** argv) {
            "Curently only raw unsigned 8bit (u8) mono audio is supported, but\n"
            "samplerate may vary. You can convert other formats before processing.\n"
            "\n"
-           "On lower samplerates and frame sizes this may perform sub-optimally. Eg.:\n"
-           "When set to detect 440Hz (at 8000Hz samplerate and ~4000 samples)\n"
-           "it actually detects something around 438,3Hz rather than 400Hz...\n"
-           "If you can't increase samplerate way around this is just to increase sensitivity.\n"
+           "On lower samplerates and frame sizes this may perform sub-optimally:\n"
+           "the bandwidth of each detector is roughly samplerate/count Hz, so\n"
+           "short frames will also respond to neighbouring frequencies.\n"
+           "If you can't increase the frame size, way around this is just to increase treshold.\n"
            "\n"
            ,argv[0]
    );
@@ -82,10 +54,12 @@ void print_help(char ** argv) {
            "\t-a <file>\tOutput to file (append) (default STDOUT)\n"
            "\n"
            "\t-r <samplerate>\tInput samplerate (deault 8000 Hz)\n"
+           "\t-D <rate>\tDecimate input to about rate Hz before detection (default 8000 Hz, 0 disables)\n"
            "\t-c <count>\tFrame size in samples (default 4000 Samples)\n"
            "\t-d <divisor>\tFrame size ( count = samplerate/divisor ) (default 2)\n"
            "\n"
            "\t-f <freq>\tAdd frequency in Hz to detect (use multiple times, default 440 Hz)\n"
+           "\t-k\t\tAdd the 8 DTMF frequencies and print the decoded key (or -)\n"
            "\n"
            "\t-n <format>\tSet number output format\n"
            "\t\tf: float\t23.4223 (default)\n"
@@ -118,6 +92,7 @@ void print_help(char ** argv) {
    printf(
            "Frequencies for DTMF decoding:\n"
            "\t-f 697 -f 770 -f 852 -f 941 -f 1209 -f 1336 -f 1477 -f 1633 -t 10\n"
+           "\tor simply: -k -t 10\n"
    );
 }
 
@@ -131,6 +106,7 @@ void addfreq(float *freqs, float freq) {
 int main(int argc, char ** argv) {
    int samplerate = 8000;
    int samplecount = 4000;
+   int detectrate = 8000;
 
    int treshold = -1;
    char filter = 0;
@@ -138,13 +114,16 @@ int main(int argc, char ** argv) {
 
    char format=0;
    char verbose=1;
+   char keypad=0;
 
-   float freqs[argc+1]; freqs[0]=-1;
+   float freqs[argc+DTMF_KEYPAD_FREQUENCY_COUNT+1]; freqs[0]=-1;
+
+   INSTR_INIT("goertzel");
 
 
    float floatarg;
    int opt;
-   while ((opt = getopt(argc, argv, "?i:o:a:r:c:d:f:t:n:l:uq")) != -1) {
+   while ((opt = getopt(argc, argv, "?i:o:a:r:D:c:d:f:kt:n:l:uq")) != -1) {
       switch (opt) {
          case 'i':
             freopen(optarg, "r", stdin);
@@ -158,6 +137,9 @@ int main(int argc, char ** argv) {
          case 'r':
             samplerate = atoi(optarg);
             break;
+         case 'D':
+            detectrate = atoi(optarg);
+            break;
          case 'c':
             samplecount = atoi(optarg);
             break;
@@ -168,6 +150,9 @@ int main(int argc, char ** argv) {
             sscanf(optarg,"%f",&floatarg);
             addfreq(freqs, floatarg);
             break;
+         case 'k':
+            keypad = 1;
+            break;
          case 't':
             treshold = atoi(optarg);
             break;
@@ -190,8 +175,29 @@ int main(int argc, char ** argv) {
       }
    }
 
+   int keypad_base = 0; //Index of the first DTMF frequency in freqs
+   if(keypad) {
+      while(freqs[keypad_base]!=-1) keypad_base++;
+      for(int k=0;k<DTMF_KEYPAD_FREQUENCY_COUNT;k++) addfreq(freqs, dtmf_keypad_hz[k]);
+   }
    if(freqs[0]==-1) addfreq(freqs, 440);
-   float samples[samplecount];
+
+   int freqcount = 0;
+   while(freqs[freqcount]!=-1) freqcount++;
+
+   //The detector is opaque, so ask the library how big it is
+   void *detector_memory = malloc(dtmf_detector_size());
+   dtmf_detector *detector = NULL;
+   dtmf_status status = dtmf_detector_init(detector_memory, dtmf_detector_size(),
+                                           samplerate, detectrate < 0 ? 0 : detectrate,
+                                           freqs, freqcount, samplecount, &detector);
+   if(status != DTMF_OK || samplecount <= 0) {
+      fprintf(stderr, "%s: Can't detect with these settings: %s\n", argv[0],
+              status != DTMF_OK ? dtmf_strerror(status) : "Frame size");
+      return 1;
+   }
+
+   uint8_t frame[samplecount];
    float position = 0;
 
    if(verbose) {
@@ -199,37 +205,44 @@ int main(int argc, char ** argv) {
               "#Detected tone: %.2f Hz\n"
               "#Sample rate: %d Hz\n"
               "#Frame length: %d samples\n"
+              "#Decimation: %d (detecting at %d Hz)\n"
               "#Treshold: %d\n"
               "#\n"
-              ,freqs[0],samplerate,samplecount,treshold);
+              ,freqs[0],samplerate,samplecount,dtmf_detector_factor(detector),dtmf_detector_detect_rate(detector),treshold);
       fflush(stderr);
 
       printf("#Position");
       int i; for(i=0;freqs[i]!=-1;i++) {
          printf("\t%2.0fHz",freqs[i]); //TODO: print decimal places
       }
+      if(keypad) printf("\tKey");
       puts("");
    }
 
    int i;
    char print=0, printnow=0;
-   char laststate[argc]; for(i=0;freqs[i]!=-1;i++) laststate[i]=-1;
+   char laststate[freqcount]; for(i=0;freqs[i]!=-1;i++) laststate[i]=-1;
    while(!feof(stdin)) {
 
       //Sample data
-      for(i=0;i<samplecount && !feof(stdin);i++) {
-         unsigned char sample;
-         fread(&sample,1,1,stdin);
-         samples[i]=sample;
-         // printf("%i: %f\n", i, samples[i]);
-      }
+      INSTR_BEGIN(t_read);
+      int count = fread(frame,1,samplecount,stdin);
+      INSTR_END(INSTR_STAGE_READ, t_read);
+      INSTR_POLL(); //Before the EOF check, so a signal sent while blocked isn't lost
+      if(count == 0) break;
+      //Pad a short last frame with silence, so every frame has the same bandwidth
+      if(count < samplecount) memset(frame + count, 127, samplecount - count);
+      INSTR_COUNT(INSTR_COUNT_BYTES_READ, count);
+      INSTR_COUNT(INSTR_COUNT_SAMPLES, count);
+      INSTR_COUNT(INSTR_COUNT_FRAMES, 1);
 
       //Apply goertzel
-      float power[argc];
+      float power[freqcount];
+      INSTR_BEGIN(t_detect);
+      dtmf_detector_process(detector, frame, samplecount, power);
+      INSTR_END(INSTR_STAGE_DETECT, t_detect);
       print=0;
       for(i=0;freqs[i]!=-1;i++) {
-         power[i] = goertzel_mag(samplecount, freqs[i], samplerate, samples);
-
          //Decide if we will print
          printnow = under ? power[i] < treshold : power[i] > treshold; //Is over/under treshold?
          switch(filter) {
@@ -248,6 +261,7 @@ int main(int argc, char ** argv) {
 
       //Print data
       if(print) {
+         INSTR_BEGIN(t_format);
          printf("%8.2f", position);
          for(i=0;freqs[i]!=-1;i++) {
             printf("\t");
@@ -267,13 +281,17 @@ int main(int argc, char ** argv) {
                   printf("%7.5f",power[i]);
             }
          }
+         if(keypad) printf("\t%c", dtmf_decode_key(&power[keypad_base], treshold));
          puts("");
          fflush(stdout);
+         INSTR_END(INSTR_STAGE_FORMAT, t_format);
       }
 
       //Increase time
       position += ((float)samplecount/(float)samplerate);
    }
+
+   free(detector_memory);
 }
 
 #pragma clang diagnostic pop
\ No newline at end of file
@@ -0,0 +1,118 @@
+///////////////////////////////////////////////////////////////////////////////
+//          University of Hawaii, College of Engineering
+//          ee469_lab01_dtmf_wav_gen - EE 469 - Fall 2022
+//
+/// Opt-in hot-path instrumentation:  Summary and signal handling
+///
+/// @see instrument.h
+///
+/// @file instrument.c
+/// @version 1.0
+///
+/// @author Mark Nelson <marknels@hawaii.edu>
+/// @date   04_Oct_2022
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef DTMF_INSTRUMENT
+   #error "instrument.c is only built with -DDTMF_INSTRUMENT=ON"
+#endif
+
+#define _POSIX_C_SOURCE 200809L  // For sigaction() and clock_gettime()
+
+#include <stdio.h>   // For fprintf()
+#include <stdlib.h>  // For atexit()
+#include <signal.h>  // For sigaction()
+#include <time.h>    // For clock_gettime()
+
+#include "instrument.h"
+
+uint64_t gInstrTicks[ INSTR_STAGE_COUNT ];
+uint64_t gInstrCalls[ INSTR_STAGE_COUNT ];
+uint64_t gInstrCounters[ INSTR_COUNT_COUNT ];
+
+volatile sig_atomic_t gInstrDumpRequested = 0;
+
+static const char* gInstrProgramName = "";
+
+static uint64_t gStartTicks = 0;  /// instr_now() when instr_init() ran
+static uint64_t gStartNs    = 0;  /// The monotonic clock when instr_init() ran
+
+static const char* STAGE_NAMES[ INSTR_STAGE_COUNT ] = {
+    "render"
+   ,"write"
+   ,"read"
+   ,"detect"
+   ,"format"
+};
+
+
+/// Wall-clock nanoseconds, used to calibrate the cycle counter
+static uint64_t monotonic_ns( void ) {
+   struct timespec ts;
+   clock_gettime( CLOCK_MONOTONIC, &ts );
+   return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+}
+
+
+/// Only set a flag here.  The summary is printed from INSTR_POLL() because
+/// fprintf() isn't async-signal-safe.
+static void on_sigusr1( int signal_number ) {
+   (void) signal_number;
+   gInstrDumpRequested = 1;
+}
+
+
+/// Print the summary to stderr
+///
+/// The cycle counter is converted to time by comparing it to the monotonic
+/// clock over the life of the program.
+void instr_dump( void ) {
+   double elapsed_s   = (double) ( monotonic_ns() - gStartNs ) / 1e9;
+   uint64_t ticks     = instr_now() - gStartTicks;
+   double ns_per_tick = ( ticks > 0 ) ? ( elapsed_s * 1e9 / (double) ticks ) : 0.0;
+
+   if( elapsed_s <= 0.0 ) {
+      elapsed_s = 1e-9;
+   }
+
+   fprintf( stderr, "%s: Instrumentation summary after %.6f s\n", gInstrProgramName, elapsed_s );
+   fprintf( stderr, "%s:   samples       %12llu  (%.0f samples/sec)\n", gInstrProgramName
+           ,(unsigned long long) gInstrCounters[ INSTR_COUNT_SAMPLES ]
+           ,(double) gInstrCounters[ INSTR_COUNT_SAMPLES ] / elapsed_s );
+   fprintf( stderr, "%s:   bytes written %12llu\n", gInstrProgramName
+           ,(unsigned long long) gInstrCounters[ INSTR_COUNT_BYTES_WRITTEN ] );
+   fprintf( stderr, "%s:   bytes read    %12llu\n", gInstrProgramName
+           ,(unsigned long long) gInstrCounters[ INSTR_COUNT_BYTES_READ ] );
+   fprintf( stderr, "%s:   frames        %12llu  (%.1f frames/sec)\n", gInstrProgramName
+           ,(unsigned long long) gInstrCounters[ INSTR_COUNT_FRAMES ]
+           ,(double) gInstrCounters[ INSTR_COUNT_FRAMES ] / elapsed_s );
+
+   for( int i = 0 ; i < INSTR_STAGE_COUNT ; i++ ) {
+      if( gInstrCalls[i] == 0 ) {
+         continue;
+      }
+      double stage_ns = (double) gInstrTicks[i] * ns_per_tick;
+      fprintf( stderr, "%s:   %-10s %12.3f ms  %10llu calls  %9.1f ns/call\n", gInstrProgramName
+              ,STAGE_NAMES[i]
+              ,stage_ns / 1e6
+              ,(unsigned long long) gInstrCalls[i]
+              ,stage_ns / (double) gInstrCalls[i] );
+   }
+}
+
+
+/// Remember when we started, install the SIGUSR1 handler and arrange for
+/// the summary to print on exit
+void instr_init( const char* program_name ) {
+   gInstrProgramName = program_name;
+   gStartNs    = monotonic_ns();
+   gStartTicks = instr_now();
+
+   struct sigaction action = { 0 };
+   action.sa_handler = on_sigusr1;
+   action.sa_flags   = SA_RESTART;
+   sigemptyset( &action.sa_mask );
+   sigaction( SIGUSR1, &action, NULL );
+
+   atexit( instr_dump );
+}
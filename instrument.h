@@ -0,0 +1,102 @@
+///////////////////////////////////////////////////////////////////////////////
+//          University of Hawaii, College of Engineering
+//          ee469_lab01_dtmf_wav_gen - EE 469 - Fall 2022
+//
+/// Opt-in hot-path instrumentation:  Counters and cycle timers
+///
+/// Build with `-DDTMF_INSTRUMENT=ON` to enable.  When it's disabled (the
+/// default), every macro in this file expands to nothing, so the hot paths
+/// compile exactly as if the instrumentation wasn't there.
+///
+/// When it's enabled, a summary (samples/sec, bytes written, frames/sec and
+/// the time spent in each stage) is printed to stderr when the program exits
+/// or after it receives SIGUSR1.
+///
+/// @file instrument.h
+/// @version 1.0
+///
+/// @author Mark Nelson <marknels@hawaii.edu>
+/// @date   04_Oct_2022
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>  // For fixed-length ints
+
+
+/// The stages of the pipeline that get timed
+enum instr_stage {
+    INSTR_STAGE_RENDER       /// Synthesizing a block of PCM (dtmf_synth_render)
+   ,INSTR_STAGE_WRITE        /// Writing PCM to the .wav file
+   ,INSTR_STAGE_READ         /// Reading a frame of PCM
+   ,INSTR_STAGE_DETECT       /// Decimating a frame and computing Goertzel magnitudes (dtmf_detector_process)
+   ,INSTR_STAGE_FORMAT       /// Formatting and printing results
+   ,INSTR_STAGE_COUNT
+};
+
+
+/// The things that get counted
+enum instr_counter {
+    INSTR_COUNT_SAMPLES        /// Samples generated or consumed
+   ,INSTR_COUNT_BYTES_WRITTEN  /// Bytes written to the output
+   ,INSTR_COUNT_BYTES_READ     /// Bytes read from the input
+   ,INSTR_COUNT_FRAMES         /// Frames processed by the detector
+   ,INSTR_COUNT_COUNT
+};
+
+
+#ifdef DTMF_INSTRUMENT
+
+#include <signal.h>  // For sig_atomic_t
+
+extern uint64_t gInstrTicks[ INSTR_STAGE_COUNT ];     /// Ticks spent in each stage
+extern uint64_t gInstrCalls[ INSTR_STAGE_COUNT ];     /// Times each stage ran
+extern uint64_t gInstrCounters[ INSTR_COUNT_COUNT ];  /// Event counters
+
+extern volatile sig_atomic_t gInstrDumpRequested;  /// Set by the SIGUSR1 handler
+
+extern void instr_init( const char* program_name );
+extern void instr_dump( void );
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+   #include <x86intrin.h>  // For __rdtsc()
+
+   /// Read the cycle counter
+   static inline uint64_t instr_now( void ) {
+      return __rdtsc();
+   }
+#else
+   #include <time.h>  // For clock_gettime()
+
+   /// Without a cycle counter, fall back to a monotonic clock in ns
+   static inline uint64_t instr_now( void ) {
+      struct timespec ts;
+      clock_gettime( CLOCK_MONOTONIC, &ts );
+      return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+   }
+#endif
+
+/// Install the SIGUSR1 handler and the exit-time summary
+#define INSTR_INIT( name )          instr_init( name )
+
+/// Start a timer named `t`
+#define INSTR_BEGIN( t )            uint64_t t = instr_now()
+
+/// Stop timer `t` and charge it to `stage`
+#define INSTR_END( stage, t )       do { gInstrTicks[ stage ] += instr_now() - (t); gInstrCalls[ stage ]++; } while( 0 )
+
+/// Add `n` to `counter`
+#define INSTR_COUNT( counter, n )   do { gInstrCounters[ counter ] += (n); } while( 0 )
+
+/// Print the summary if SIGUSR1 has arrived since the last poll
+#define INSTR_POLL()                do { if( gInstrDumpRequested ) { gInstrDumpRequested = 0; instr_dump(); } } while( 0 )
+
+#else  // DTMF_INSTRUMENT
+
+#define INSTR_INIT( name )          do { } while( 0 )
+#define INSTR_BEGIN( t )            do { } while( 0 )
+#define INSTR_END( stage, t )       do { } while( 0 )
+#define INSTR_COUNT( counter, n )   do { } while( 0 )
+#define INSTR_POLL()                do { } while( 0 )
+
+#endif // DTMF_INSTRUMENT